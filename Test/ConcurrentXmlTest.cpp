@@ -0,0 +1,57 @@
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Parser.hpp"
+
+// Serializes two documents with nested arrays from 8 threads at once. Each
+// conversion must match the single-threaded output: the element name of an
+// array is passed down the writers, never shared between calls.
+int main()
+{
+    const std::string inputs[] = {
+        R"({"x":[1,2,{"y":[3,4]}],"z":{"w":[[5],[6]]}})",
+        R"({"q":[7,8],"r":[{"s":[9]}]})"};
+    const std::string expected[] = {
+        "<x>1</x>\n<x>2</x>\n<x><y>3</y>\n<y>4</y></x>\n<z><w><w>5</w></w>\n<w><w>6</w></w></z>",
+        "<q>7</q>\n<q>8</q>\n<r><s>9</s></r>"};
+
+    Parser parser;
+    Json::Document documents[] = {parser.ParseJsonDocument(inputs[0]), parser.ParseJsonDocument(inputs[1])};
+    for (int i = 0; i < 2; i++)
+    {
+        if (documents[i].Root()->toXmlString() != expected[i])
+        {
+            std::cerr << "Unexpected XML for input " << i << ": " << documents[i].Root()->toXmlString() << "\n";
+            return 1;
+        }
+    }
+
+    constexpr int kThreads = 8;
+    constexpr int kIterations = 20000;
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++)
+    {
+        threads.emplace_back([&, t]
+                             {
+                                 int which = t % 2;
+                                 for (int i = 0; i < kIterations; i++)
+                                 {
+                                     if (documents[which].Root()->toXmlString() != expected[which])
+                                         failures++;
+                                 }
+                             });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " of " << kThreads * kIterations << " concurrent conversions differed\n";
+        return 1;
+    }
+    std::cout << kThreads * kIterations << " concurrent conversions matched\n";
+    return 0;
+}
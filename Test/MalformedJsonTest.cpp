@@ -0,0 +1,166 @@
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Batch.hpp"
+#include "Bind.hpp"
+#include "Lazy.hpp"
+#include "Parser.hpp"
+#include "Tape.hpp"
+
+// Every JSON front end must reject what the tree parser rejects: the tape,
+// the lazy document once fully read, the parallel array parser and binding.
+// The valid documents are checked first so a rejection is not just a schema
+// mismatch.
+struct Item
+{
+    int64_t id = 0;
+    std::vector<int64_t> values;
+    std::string name;
+};
+
+template <>
+struct Bind::Schema<Item>
+{
+    static constexpr auto fields = Bind::Fields(
+        Bind::Field("id", &Item::id),
+        Bind::Field("values", &Item::values),
+        Bind::Field("name", &Item::name));
+};
+
+namespace
+{
+    int failures = 0;
+
+    void Fail(const std::string &what, const std::string &input)
+    {
+        if (++failures <= 20)
+            std::cerr << what << ": " << input << "\n";
+    }
+
+    bool Throws(const std::function<void()> &parse)
+    {
+        try
+        {
+            parse();
+        }
+        catch (const std::exception &)
+        {
+            return true;
+        }
+        return false;
+    }
+
+    using Check = std::pair<const char *, std::function<void(const std::string &)>>;
+
+    std::vector<Check> FrontEnds(BatchParser &batch)
+    {
+        return {
+            {"tree", [](const std::string &input)
+             {
+                 Parser parser;
+                 parser.ParseJsonDocument(input);
+             }},
+            {"tape", [](const std::string &input)
+             {
+                 Parser parser;
+                 parser.ParseJsonTape(input);
+             }},
+            {"lazy", [](const std::string &input)
+             {
+                 Json::LazyDocument document(input);
+                 document.Root().Get();
+             }},
+            {"batch", [&batch](const std::string &input)
+             {
+                 batch.ParseJsonArray(input);
+             }},
+            {"bind", [](const std::string &input)
+             {
+                 std::vector<Item> items;
+                 Bind::ParseJson(input, items);
+             }}};
+    }
+}
+
+int main()
+{
+    const char *const valid[] = {
+        R"([])",
+        R"([{"id":1,"values":[1,2],"name":"a"},{"id":2,"skip":{"x":[1,{"y":"]"}]}}])",
+        R"( [ { "id" : 1 , "values" : [ ] } , { } ] )"};
+    const char *const malformed[] = {
+        R"([{"id":1,},{"id":2}])",
+        R"([{"id":1},])",
+        R"([,{"id":1}])",
+        R"([{"id":1} {"id":2}])",
+        R"([{"id":1}{"id":2}])",
+        R"([{"id" 1}])",
+        R"([{"id":1,,"name":"a"}])",
+        R"([{1:2}])",
+        R"([{"id":1,"values":[1 2]}])",
+        R"([{"id":1,"values":[1,]}])",
+        R"([{"id":tru}])",
+        R"([{"name":"unterminated}])",
+        R"([{"id":1}})",
+        R"([{"id":1]])",
+        R"([{"id":1})",
+        R"([{"id":1}]])",
+        R"([{"id":1}] x)",
+        R"([)",
+        R"(])"};
+    // Binding skips unknown members by bracket matching without validating
+    // them, so only the other front ends must reject these.
+    const char *const malformedSkipped[] = {
+        R"([{"id":1,"skip":{"x":[1,]}}])",
+        R"([{"id":1,"skip":{"x":1,}}])",
+        R"([{"id":1,"skip":{"x" 1}}])"};
+
+    BatchParser batch(2);
+    std::vector<Check> frontEnds = FrontEnds(batch);
+    for (const char *input : valid)
+    {
+        for (const Check &check : frontEnds)
+        {
+            if (Throws([&] { check.second(input); }))
+                Fail(std::string(check.first) + " rejected valid input", input);
+        }
+    }
+    for (const char *input : malformed)
+    {
+        for (const Check &check : frontEnds)
+        {
+            if (!Throws([&] { check.second(input); }))
+                Fail(std::string(check.first) + " accepted malformed input", input);
+        }
+    }
+    for (const char *input : malformedSkipped)
+    {
+        for (const Check &check : frontEnds)
+        {
+            if (std::string(check.first) != "bind" && !Throws([&] { check.second(input); }))
+                Fail(std::string(check.first) + " accepted malformed input", input);
+        }
+    }
+
+    // Missing members give invalid refs that can be indexed further but not read.
+    Parser parser;
+    Json::Tape tape = parser.ParseJsonTape(valid[1]);
+    Json::TapeRef missing = tape.Root()[5]["id"];
+    if (missing || missing[0]["x"] || !Throws([&] { missing.AsInt64(); }) || tape.Root()[0]["id"].AsInt64() != 1)
+        Fail("tape invalid ref misbehaved", valid[1]);
+
+    Json::LazyDocument lazy(valid[1]);
+    Json::LazyRef absent = lazy.Root()[1]["nope"];
+    if (absent || absent["x"][0] || !Throws([&] { absent.Get(); }))
+        Fail("lazy invalid ref misbehaved", valid[1]);
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " failures\n";
+        return 1;
+    }
+    std::cout << "malformed JSON was rejected by every front end\n";
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include "Number.hpp"
+
+// Checks ParseDouble bit for bit against strtod on edge cases and random
+// lexemes on both sides of its fast path, ParseInteger at the 64-bit limits,
+// and that numbers write back as they were read.
+namespace
+{
+    int failures = 0;
+
+    void Fail(const std::string &what)
+    {
+        if (++failures <= 10)
+            std::cerr << what << "\n";
+    }
+
+    void CheckDouble(const std::string &lexeme)
+    {
+        double value;
+        double expected = std::strtod(lexeme.c_str(), nullptr);
+        if (!ParseDouble(lexeme, value))
+            Fail("ParseDouble rejected " + lexeme);
+        else if (std::memcmp(&value, &expected, sizeof(double)) != 0)
+            Fail("ParseDouble(" + lexeme + ") = " + std::to_string(value) + ", strtod gives " + std::to_string(expected));
+    }
+
+    std::string RandomLexeme(std::mt19937 &random)
+    {
+        std::string lexeme = random() % 2 ? "-" : "";
+        size_t digits = 1 + random() % 25;
+        lexeme += char('1' + random() % 9);
+        for (size_t i = 1; i < digits; i++)
+            lexeme += char('0' + random() % 10);
+        if (random() % 2)
+            lexeme.insert(lexeme.size() - random() % digits, ".");
+        if (lexeme.back() == '.')
+            lexeme += '0';
+        if (random() % 2)
+        {
+            int exponent = static_cast<int>(random() % 700) - 350;
+            lexeme += (random() % 2 ? "e" : "E") + std::to_string(exponent);
+        }
+        return lexeme;
+    }
+}
+
+int main()
+{
+    const char *const edges[] = {
+        "0", "-0", "0.0", "-0.0", "0e0", "-0e-5", "1", "-1", "0.1", "0.3", "1.5", "123.456e2",
+        "9007199254740992", "9007199254740993", "9999999999999999999", "10000000000000000000",
+        "1.7976931348623157e308", "1.7976931348623158e308", "1e308", "1e309", "-1e309",
+        "2.2250738585072014e-308", "2.2250738585072011e-308", "4.9e-324", "5e-324", "2e-324",
+        "1e-400", "-1e-400", "1e22", "1e23", "123456789012345678901234567890",
+        "0.000000000000000000000000000001", "1E+2", "1e-0", "00012", "-007.50"};
+    for (const char *edge : edges)
+        CheckDouble(edge);
+
+    std::mt19937 random(11);
+    for (int round = 0; round < 200000; round++)
+        CheckDouble(RandomLexeme(random));
+
+    int64_t i;
+    uint64_t u;
+    if (!ParseInteger("-9223372036854775808", i) || i != INT64_MIN)
+        Fail("ParseInteger rejected INT64_MIN");
+    if (!ParseInteger("9223372036854775807", i) || i != INT64_MAX)
+        Fail("ParseInteger rejected INT64_MAX");
+    if (ParseInteger("9223372036854775808", i) || ParseInteger("-9223372036854775809", i))
+        Fail("ParseInteger accepted an int64 overflow");
+    if (!ParseInteger("18446744073709551615", u) || u != UINT64_MAX)
+        Fail("ParseInteger rejected UINT64_MAX");
+    if (ParseInteger("18446744073709551616", u) || ParseInteger("-1", u))
+        Fail("ParseInteger accepted a uint64 overflow");
+    if (ParseInteger("1.0", i) || ParseInteger("1e2", i))
+        Fail("ParseInteger accepted a fraction or exponent");
+
+    const char *const roundTrips[] = {
+        "0", "-0", "-0.0", "1.50", "1e5", "-12", "9223372036854775807", "-9223372036854775808",
+        "18446744073709551615", "18446744073709551616", "3.14159265358979323846"};
+    for (const char *lexeme : roundTrips)
+    {
+        std::string written;
+        {
+            Writer out(written);
+            Number::FromLexeme(lexeme).Write(out);
+        }
+        if (written != lexeme)
+            Fail(std::string("Number wrote ") + lexeme + " back as " + written);
+    }
+
+    Number negativeZero = Number::FromLexeme("-0");
+    if (negativeZero.IsInteger() || !std::signbit(negativeZero.AsDouble()))
+        Fail("-0 lost its sign");
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " failures\n";
+        return 1;
+    }
+    std::cout << "numbers matched strtod and round-tripped\n";
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include "Parser.hpp"
+#include "PushParser.hpp"
+
+// Feeds random documents to the push parsers in random chunks, down to single
+// bytes, and checks each tree serializes exactly like a parse of the whole
+// input. Truncated documents must be rejected however they are split.
+namespace
+{
+    int failures = 0;
+
+    void Fail(const std::string &what, const std::string &input)
+    {
+        if (++failures <= 10)
+            std::cerr << what << " for input: " << input << "\n";
+    }
+
+    void RandomJson(std::mt19937 &random, std::string &out, int depth)
+    {
+        static const char *const scalars[] = {
+            "\"plain\"", "\"esc\\\"aped \\\\ \\u00e9\"", "\"\"", "\"{[,:]}\"", "0", "-12",
+            "3.25e-7", "-0", "18446744073709551615", "true", "false", "null"};
+        if (depth > 5 || random() % 3 == 0)
+        {
+            out += scalars[random() % (sizeof(scalars) / sizeof(scalars[0]))];
+            return;
+        }
+
+        bool object = random() % 2 == 0;
+        out += object ? "{" : "[ ";
+        size_t count = random() % 5;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i > 0)
+                out += random() % 2 ? "," : " ,\n\t";
+            if (object)
+                out += "\"key" + std::to_string(random() % 4) + "\" : ";
+            RandomJson(random, out, depth + 1);
+        }
+        out += object ? "}" : " ]";
+    }
+
+    void RandomElement(std::mt19937 &random, std::string &out, int depth)
+    {
+        static const char *const texts[] = {"text", "a &amp; b", "42", "-1.5", "true", "null", "<![CDATA[<raw>]]>"};
+        std::string name = "e" + std::to_string(random() % 3);
+        out += "<" + name;
+        if (random() % 3 == 0)
+            out += " id=\"" + std::to_string(random() % 10) + "\"";
+        if (random() % 5 == 0)
+        {
+            out += "/>";
+            return;
+        }
+        out += ">";
+        if (depth > 4 || random() % 3 == 0)
+        {
+            out += texts[random() % (sizeof(texts) / sizeof(texts[0]))];
+        }
+        else
+        {
+            size_t count = random() % 4;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (random() % 4 == 0)
+                    out += "<!-- note -->";
+                out += "\n  ";
+                RandomElement(random, out, depth + 1);
+            }
+        }
+        out += "</" + name + ">";
+    }
+
+    template <typename PushParser>
+    std::string FeedInChunks(std::mt19937 &random, std::string_view input)
+    {
+        PushParser parser;
+        size_t limit = 1 + random() % 32;
+        for (size_t pos = 0; pos < input.size();)
+        {
+            size_t size = 1 + random() % limit;
+            parser.feed(input.substr(pos, size));
+            pos += size;
+        }
+        return parser.finish().Root()->toJsonString();
+    }
+
+    template <typename PushParser>
+    bool RejectsInChunks(std::mt19937 &random, std::string_view input)
+    {
+        try
+        {
+            FeedInChunks<PushParser>(random, input);
+        }
+        catch (const std::exception &)
+        {
+            return true;
+        }
+        return false;
+    }
+}
+
+int main()
+{
+    std::mt19937 random(7);
+    Parser parser;
+
+    for (int round = 0; round < 2000; round++)
+    {
+        std::string json = " ";
+        RandomJson(random, json, 0);
+        json += "\n";
+        std::string expected = parser.ParseJsonDocument(json).Root()->toJsonString();
+        if (FeedInChunks<JsonPushParser>(random, json) != expected)
+            Fail("JSON chunks differ", json);
+
+        std::string cut = json.substr(0, json.find_last_not_of(" \n") * (random() % 100) / 100);
+        if (cut.find_first_not_of(" \n") != std::string::npos && cut.find_first_of("{[") != std::string::npos &&
+            !RejectsInChunks<JsonPushParser>(random, cut))
+            Fail("Truncated JSON accepted", cut);
+    }
+
+    for (int round = 0; round < 2000; round++)
+    {
+        std::string xml = "<?xml version=\"1.0\"?>\n";
+        RandomElement(random, xml, 0);
+        std::string expected = parser.ParseXmlDocument(xml).Root()->toJsonString();
+        if (FeedInChunks<XmlPushParser>(random, xml) != expected)
+            Fail("XML chunks differ", xml);
+
+        std::string cut = xml.substr(0, xml.size() - 1 - random() % (xml.size() / 2));
+        if (!RejectsInChunks<XmlPushParser>(random, cut))
+            Fail("Truncated XML accepted", cut);
+    }
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " failures\n";
+        return 1;
+    }
+    std::cout << "chunked parses matched whole-input parses\n";
+    return 0;
+}
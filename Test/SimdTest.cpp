@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include "Simd.hpp"
+
+// Runs every kernel this CPU supports over random text biased towards the
+// classified bytes and checks the masks, scans, string tracking and bracket
+// matching against byte-at-a-time references.
+namespace
+{
+    int failures = 0;
+
+    void Fail(const char *kernel, const std::string &what)
+    {
+        if (++failures <= 10)
+            std::cerr << kernel << ": " << what << "\n";
+    }
+
+    std::string RandomText(std::mt19937 &random, size_t size)
+    {
+        static const char alphabet[] = "\"\\{}[]:, \t\n\rab0\x7f\x80\xff";
+        std::string text(size, ' ');
+        for (char &c : text)
+            c = alphabet[random() % (sizeof(alphabet) - 1)];
+        return text;
+    }
+
+    // Long runs of one byte class, so the vector scans get past kScalarRun.
+    std::string RandomRuns(std::mt19937 &random, size_t size)
+    {
+        static const char runs[] = " \t\n\rab\"\\";
+        std::string text;
+        while (text.size() < size)
+            text.append(random() % 200, runs[random() % (sizeof(runs) - 1)]);
+        text.resize(size);
+        return text;
+    }
+
+    Simd::BlockMasks ReferenceMasks(const char *data, size_t size)
+    {
+        Simd::BlockMasks masks{0, 0, 0, 0};
+        for (size_t i = 0; i < size; i++)
+        {
+            uint64_t bit = uint64_t(1) << i;
+            char c = data[i];
+            if (c == '"')
+                masks.quote |= bit;
+            else if (c == '\\')
+                masks.backslash |= bit;
+            else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',')
+                masks.structural |= bit;
+            else if (Simd::IsWhitespace(c))
+                masks.whitespace |= bit;
+        }
+        return masks;
+    }
+
+    // Bytes inside strings, opening quote included, for a whole text.
+    std::string ReferenceInString(const std::string &text)
+    {
+        std::string inside(text.size(), '0');
+        bool inString = false;
+        bool escaped = false;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            if (escaped)
+                escaped = false;
+            else if (text[i] == '\\')
+                escaped = true;
+            else if (text[i] == '"')
+                inString = !inString;
+            if (inString)
+                inside[i] = '1';
+        }
+        return inside;
+    }
+
+    size_t ReferenceMatchClose(const std::string &text, size_t open)
+    {
+        std::string inside = ReferenceInString(text);
+        size_t depth = 0;
+        for (size_t i = open; i < text.size(); i++)
+        {
+            if (inside[i] == '1')
+                continue;
+            if (text[i] == '{' || text[i] == '[')
+                depth++;
+            else if ((text[i] == '}' || text[i] == ']') && --depth == 0)
+                return i;
+        }
+        return text.size();
+    }
+
+    // Nested containers with strings that hold brackets and escapes.
+    void RandomJson(std::mt19937 &random, std::string &out, int depth)
+    {
+        switch (depth > 6 ? random() % 2 : random() % 4)
+        {
+        case 0:
+            out += "\"a]\\\"}\\\\\"";
+            break;
+        case 1:
+            out += std::to_string(random() % 1000);
+            break;
+        default:
+        {
+            bool object = random() % 2 == 0;
+            out += object ? '{' : '[';
+            size_t count = random() % 5;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (i > 0)
+                    out += ",\n  ";
+                if (object)
+                    out += "\"{k\":";
+                RandomJson(random, out, depth + 1);
+            }
+            out += object ? '}' : ']';
+        }
+        }
+    }
+
+    void CheckKernel(const char *kernel, std::mt19937 &random)
+    {
+        for (int round = 0; round < 2000; round++)
+        {
+            std::string text = RandomText(random, Simd::kBlockSize);
+            size_t size = random() % (Simd::kBlockSize + 1);
+            Simd::BlockMasks masks;
+            Simd::Classify(text.data(), size, masks);
+            Simd::BlockMasks expected = ReferenceMasks(text.data(), size);
+            if (masks.quote != expected.quote || masks.backslash != expected.backslash ||
+                masks.structural != expected.structural || masks.whitespace != expected.whitespace)
+                Fail(kernel, "Classify differs for " + std::to_string(size) + " bytes");
+        }
+
+        for (int round = 0; round < 500; round++)
+        {
+            std::string text = RandomRuns(random, 1 + random() % 2000);
+            size_t pos = random() % text.size();
+            size_t quote = pos, space = pos;
+            while (quote < text.size() && text[quote] != '"' && text[quote] != '\\')
+                quote++;
+            while (space < text.size() && Simd::IsWhitespace(text[space]))
+                space++;
+            if (Simd::FindQuoteOrBackslash(text.data(), pos, text.size()) != quote)
+                Fail(kernel, "FindQuoteOrBackslash differs at " + std::to_string(pos));
+            if (Simd::SkipWhitespace(text.data(), pos, text.size()) != space)
+                Fail(kernel, "SkipWhitespace differs at " + std::to_string(pos));
+        }
+
+        for (int round = 0; round < 500; round++)
+        {
+            std::string text = RandomText(random, 1 + random() % 1000);
+            std::string expected = ReferenceInString(text);
+            Simd::StringScanner strings;
+            Simd::BlockMasks masks;
+            for (size_t block = 0; block < text.size(); block += Simd::kBlockSize)
+            {
+                size_t length = std::min(text.size() - block, Simd::kBlockSize);
+                Simd::Classify(text.data() + block, length, masks);
+                uint64_t inside = strings.Next(masks);
+                for (size_t i = 0; i < length; i++)
+                {
+                    if (((inside >> i) & 1) != uint64_t(expected[block + i] == '1'))
+                    {
+                        Fail(kernel, "StringScanner differs at " + std::to_string(block + i));
+                        break;
+                    }
+                }
+            }
+        }
+
+        for (int round = 0; round < 500; round++)
+        {
+            std::string text = "  ";
+            RandomJson(random, text, 0);
+            if (round % 3 == 0)
+                text.resize(text.size() / 2); // never closed
+            size_t open = text.find_first_of("{[");
+            if (open == std::string::npos)
+                continue;
+            if (Simd::MatchClose(text.data(), open, text.size()) != ReferenceMatchClose(text, open))
+                Fail(kernel, "MatchClose differs for " + text);
+        }
+    }
+}
+
+int main()
+{
+    int kernels = 0;
+    for (const char *kernel : {"scalar", "sse4.2", "avx2"})
+    {
+        if (!Simd::UseKernel(kernel))
+            continue;
+        std::mt19937 random(42);
+        CheckKernel(kernel, random);
+        kernels++;
+    }
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " mismatches\n";
+        return 1;
+    }
+    std::cout << kernels << " kernels matched the references\n";
+    return 0;
+}
@@ -0,0 +1,313 @@
+#include <benchmark/benchmark.h>
+#include <sys/resource.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include "Corpus.hpp"
+#include "Parser.hpp"
+#include "Tokenizer.hpp"
+
+// Throughput, allocations per document and peak RSS of the tokenizers,
+// parsers and serializers over the synthetic corpus.
+//
+//   bench [--corpus_max=SIZE] [google benchmark flags]
+//
+// Corpus sizes run from 1K up to SIZE (default 1M, at most 1G; K/M/G
+// suffixes accepted).
+
+// On glibc every allocation is counted, operator new and arena blocks
+// alike, by wrapping the C allocator. Elsewhere allocs/doc reads 0.
+static std::atomic<size_t> allocations{0};
+
+#if defined(__GLIBC__)
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *pointer, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+
+    void *malloc(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+    void *calloc(size_t count, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(count, size);
+    }
+    void *realloc(void *pointer, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(pointer, size);
+    }
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_memalign(alignment, size);
+    }
+    int posix_memalign(void **pointer, size_t alignment, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        *pointer = __libc_memalign(alignment, size);
+        return *pointer == nullptr ? ENOMEM : 0;
+    }
+}
+#endif
+
+namespace
+{
+    enum class FORMAT
+    {
+        JSON,
+        XML
+    };
+
+    // Inputs of the size being measured; benchmarks run size by size, so
+    // larger corpora replace smaller ones instead of piling up.
+    const std::string &Input(FORMAT format, Corpus::SHAPE shape, size_t bytes)
+    {
+        static size_t cachedBytes = 0;
+        static std::map<std::pair<FORMAT, Corpus::SHAPE>, std::string> cache;
+
+        if (bytes != cachedBytes)
+        {
+            cache.clear();
+            cachedBytes = bytes;
+        }
+        std::string &input = cache[{format, shape}];
+        if (input.empty())
+            input = format == FORMAT::JSON ? Corpus::Json(shape, bytes) : Corpus::Xml(shape, bytes);
+        return input;
+    }
+
+    size_t PeakRss()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+    }
+
+    // Wraps a benchmark body with the common counters: `processed` bytes
+    // per iteration, allocations per iteration (one document) and peak RSS.
+    template <typename BodyFn>
+    void Measure(benchmark::State &state, size_t processed, BodyFn body)
+    {
+        size_t before = allocations.load(std::memory_order_relaxed);
+        for (auto _ : state)
+            body();
+        size_t after = allocations.load(std::memory_order_relaxed);
+
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * processed));
+        state.counters["allocs/doc"] = benchmark::Counter(static_cast<double>(after - before),
+                                                          benchmark::Counter::kAvgIterations);
+        state.counters["peak_rss"] = benchmark::Counter(static_cast<double>(PeakRss()),
+                                                        benchmark::Counter::kDefaults,
+                                                        benchmark::Counter::OneK::kIs1024);
+    }
+
+    void LexJson(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::JSON, shape, bytes);
+        Measure(state, input.size(), [&]
+                {
+                    JsonLexer lexer(input);
+                    TokenJson token;
+                    size_t count = 0;
+                    while (lexer.NextToken(token))
+                        count++;
+                    benchmark::DoNotOptimize(count); });
+    }
+
+    void LexXml(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::XML, shape, bytes);
+        Measure(state, input.size(), [&]
+                {
+                    XmlLexer lexer(input);
+                    TokenXml token;
+                    size_t count = 0;
+                    while (lexer.NextToken(token))
+                        count++;
+                    benchmark::DoNotOptimize(count); });
+    }
+
+    // Token vectors, as returned by Tokenizer.
+    void TokenizeJson(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::JSON, shape, bytes);
+        Tokenizer tokenizer;
+        Measure(state, input.size(), [&]
+                { benchmark::DoNotOptimize(tokenizer.TokenizeJson(input)); });
+    }
+
+    void TokenizeXml(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::XML, shape, bytes);
+        Tokenizer tokenizer;
+        Measure(state, input.size(), [&]
+                { benchmark::DoNotOptimize(tokenizer.TokenizeXml(input)); });
+    }
+
+    void ParseJson(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::JSON, shape, bytes);
+        Parser parser;
+        Measure(state, input.size(), [&]
+                {
+                    Json::Document document = parser.ParseJsonDocument(input);
+                    benchmark::DoNotOptimize(document.Root()); });
+    }
+
+    // Steady state of a long-lived parser and document.
+    void ParseJsonReused(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::JSON, shape, bytes);
+        Parser parser;
+        Json::Document document;
+        parser.ParseJsonDocument(input, document);
+        Measure(state, input.size(), [&]
+                {
+                    parser.ParseJsonDocument(input, document);
+                    benchmark::DoNotOptimize(document.Root()); });
+    }
+
+    void ParseXml(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::XML, shape, bytes);
+        Parser parser;
+        Measure(state, input.size(), [&]
+                {
+                    Xml::Document document = parser.ParseXmlDocument(input);
+                    benchmark::DoNotOptimize(document.Root()); });
+    }
+
+    void ParseXmlReused(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::XML, shape, bytes);
+        Parser parser;
+        Xml::Document document;
+        parser.ParseXmlDocument(input, document);
+        Measure(state, input.size(), [&]
+                {
+                    parser.ParseXmlDocument(input, document);
+                    benchmark::DoNotOptimize(document.Root()); });
+    }
+
+    // Serializers are rated by the bytes they emit.
+    void ToJsonString(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        Json::Document document = Parser().ParseJsonDocument(Input(FORMAT::JSON, shape, bytes));
+        Measure(state, document.Root()->toJsonString().size(), [&]
+                { benchmark::DoNotOptimize(document.Root()->toJsonString()); });
+    }
+
+    void ToXmlString(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        Xml::Document document = Parser().ParseXmlDocument(Input(FORMAT::XML, shape, bytes));
+        Measure(state, document.Root()->toXmlString().size(), [&]
+                { benchmark::DoNotOptimize(document.Root()->toXmlString()); });
+    }
+
+    void JsonToXml(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::JSON, shape, bytes);
+        Parser parser;
+        Measure(state, input.size(), [&]
+                { benchmark::DoNotOptimize(parser.JsonToXml(input)); });
+    }
+
+    void XmlToJson(benchmark::State &state, Corpus::SHAPE shape, size_t bytes)
+    {
+        const std::string &input = Input(FORMAT::XML, shape, bytes);
+        Parser parser;
+        Measure(state, input.size(), [&]
+                { benchmark::DoNotOptimize(parser.XmlToJson(input)); });
+    }
+
+    using BenchmarkFn = void (*)(benchmark::State &, Corpus::SHAPE, size_t);
+
+    const std::pair<const char *, BenchmarkFn> kBenchmarks[] = {
+        {"LexJson", LexJson},
+        {"LexXml", LexXml},
+        {"TokenizeJson", TokenizeJson},
+        {"TokenizeXml", TokenizeXml},
+        {"ParseJson", ParseJson},
+        {"ParseJsonReused", ParseJsonReused},
+        {"ParseXml", ParseXml},
+        {"ParseXmlReused", ParseXmlReused},
+        {"ToJsonString", ToJsonString},
+        {"ToXmlString", ToXmlString},
+        {"JsonToXml", JsonToXml},
+        {"XmlToJson", XmlToJson},
+    };
+
+    const std::pair<const char *, size_t> kSizes[] = {
+        {"1K", size_t(1) << 10},
+        {"64K", size_t(64) << 10},
+        {"1M", size_t(1) << 20},
+        {"16M", size_t(16) << 20},
+        {"256M", size_t(256) << 20},
+        {"1G", size_t(1) << 30},
+    };
+
+    size_t ParseSize(const char *text)
+    {
+        char *end = nullptr;
+        size_t size = std::strtoull(text, &end, 10);
+        switch (*end)
+        {
+        case 'K':
+        case 'k':
+            return size << 10;
+        case 'M':
+        case 'm':
+            return size << 20;
+        case 'G':
+        case 'g':
+            return size << 30;
+        default:
+            return size;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t maxSize = size_t(1) << 20;
+
+    // Takes our own flag out before Google Benchmark sees the arguments.
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strncmp(argv[i], "--corpus_max=", 13) == 0)
+            maxSize = ParseSize(argv[i] + 13);
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+
+    for (const auto &size : kSizes)
+    {
+        if (size.second > maxSize)
+            break;
+        for (const auto &bench : kBenchmarks)
+            for (Corpus::SHAPE shape : Corpus::kShapes)
+            {
+                std::string name = std::string(bench.first) + "/" + Corpus::Name(shape) + "/" + size.first;
+                benchmark::RegisterBenchmark(name.c_str(), bench.second, shape, size.second);
+            }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,282 @@
+#include "Corpus.hpp"
+#include "Parser.hpp"
+
+namespace
+{
+    // xorshift64*: small, fast and the same everywhere, unlike the standard
+    // distributions.
+    class Random
+    {
+    private:
+        uint64_t state;
+
+    public:
+        explicit Random(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+        inline uint64_t Next()
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 0x2545F4914F6CDD1Dull;
+        }
+        inline uint64_t Below(uint64_t bound) { return Next() % bound; }
+    };
+
+    const char *const kWords[] = {
+        "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit",
+        "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "et",
+        "dolore", "magna", "aliqua", "enim", "ad", "minim", "veniam", "quis"};
+    constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+
+    void AppendWords(std::string &out, Random &random, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i > 0)
+                out += ' ';
+            out += kWords[random.Below(kWordCount)];
+        }
+    }
+
+    // Fixed-point text, so output does not depend on printf or the locale.
+    void AppendDecimal(std::string &out, Random &random)
+    {
+        if (random.Below(4) == 0)
+            out += '-';
+        out += std::to_string(random.Below(100000));
+        out += '.';
+        std::string fraction = std::to_string(random.Below(1000));
+        out.append(3 - fraction.size(), '0');
+        out += fraction;
+    }
+
+    void AppendNumber(std::string &out, Random &random)
+    {
+        switch (random.Below(4))
+        {
+        case 0:
+            out += std::to_string(random.Below(1000));
+            break;
+        case 1:
+            out += '-';
+            out += std::to_string(random.Below(1000000000000ull));
+            break;
+        case 2:
+            AppendDecimal(out, random);
+            break;
+        default:
+            out += std::to_string(1 + random.Below(9));
+            out += '.';
+            out += std::to_string(random.Below(100));
+            out += random.Below(2) ? "e-" : "e+";
+            out += std::to_string(1 + random.Below(30));
+            break;
+        }
+    }
+
+    void DeepRecord(std::string &out, Random &random, size_t id)
+    {
+        constexpr size_t kDepth = 48;
+        for (size_t level = 0; level < kDepth; level++)
+        {
+            out += "{\"id\":";
+            out += std::to_string(id * kDepth + level);
+            out += ",\"kind\":\"";
+            out += kWords[random.Below(kWordCount)];
+            out += "\",\"node\":";
+        }
+        out += "{\"leaf\":true}";
+        out.append(kDepth, '}');
+    }
+
+    void WideRecord(std::string &out, Random &random, size_t id)
+    {
+        constexpr size_t kMembers = 300;
+        out += "{\"id\":";
+        out += std::to_string(id);
+        for (size_t i = 0; i < kMembers; i++)
+        {
+            std::string index = std::to_string(i);
+            out += ",\"field_";
+            out.append(3 - index.size(), '0');
+            out += index;
+            out += "\":";
+            switch (i % 5)
+            {
+            case 0:
+                out += std::to_string(random.Below(100000));
+                break;
+            case 1:
+                AppendDecimal(out, random);
+                break;
+            case 2:
+                out += '"';
+                AppendWords(out, random, 1 + random.Below(3));
+                out += '"';
+                break;
+            case 3:
+                out += random.Below(2) ? "true" : "false";
+                break;
+            default:
+                out += "null";
+                break;
+            }
+        }
+        out += '}';
+    }
+
+    void NumbersRecord(std::string &out, Random &random, size_t id)
+    {
+        constexpr size_t kValues = 64;
+        out += "{\"id\":";
+        out += std::to_string(id);
+        out += ",\"series\":[";
+        for (size_t i = 0; i < kValues; i++)
+        {
+            if (i > 0)
+                out += ',';
+            AppendNumber(out, random);
+        }
+        out += "]}";
+    }
+
+    void StringsRecord(std::string &out, Random &random, size_t id)
+    {
+        out += "{\"id\":";
+        out += std::to_string(id);
+        out += ",\"title\":\"";
+        AppendWords(out, random, 4);
+        out += "\",\"body\":\"";
+        for (size_t sentence = 0; sentence < 12; sentence++)
+        {
+            AppendWords(out, random, 8 + random.Below(8));
+            switch (random.Below(6))
+            {
+            case 0:
+                out += " \\\"quoted\\\"";
+                break;
+            case 1:
+                out += " C:\\\\path\\\\file";
+                break;
+            case 2:
+                out += " caf\\u00e9";
+                break;
+            case 3:
+                out += " na\xC3\xAFve \xE6\x97\xA5\xE6\x9C\xAC";
+                break;
+            case 4:
+                out += "\\n\\t";
+                break;
+            default:
+                break;
+            }
+            out += ". ";
+        }
+        out += "\"}";
+    }
+
+    void CatalogBook(std::string &out, Random &random, size_t id)
+    {
+        const char *const kGenres[] = {"Computer", "Fantasy", "Romance", "Horror", "Science Fiction"};
+
+        out += "   <book id=\"bk";
+        out += std::to_string(101 + id);
+        out += "\">\n      <author>";
+        AppendWords(out, random, 1);
+        out += ", ";
+        AppendWords(out, random, 1);
+        out += "</author>\n      <title>";
+        AppendWords(out, random, 2 + random.Below(3));
+        if (random.Below(8) == 0)
+            out += " &amp; More";
+        out += "</title>\n      <genre>";
+        out += kGenres[random.Below(5)];
+        out += "</genre>\n      <price>";
+        out += std::to_string(1 + random.Below(60));
+        out += '.';
+        out += std::to_string(10 + random.Below(90));
+        out += "</price>\n      <publish_date>";
+        out += std::to_string(2000 + random.Below(20));
+        out += '-';
+        out += std::to_string(10 + random.Below(3));
+        out += '-';
+        out += std::to_string(10 + random.Below(19));
+        out += "</publish_date>\n      <description>";
+        AppendWords(out, random, 10 + random.Below(30));
+        out += ".</description>\n   </book>\n";
+    }
+
+    // Records wrapped as {"corpus":{"record":[...]}}, so that the XML form
+    // has a single root.
+    template <typename RecordFn>
+    std::string JsonRecords(size_t bytes, uint64_t seed, RecordFn record)
+    {
+        Random random(seed);
+        std::string out = "{\"corpus\":{\"record\":[";
+        for (size_t id = 0; id == 0 || out.size() + 3 < bytes; id++)
+        {
+            if (id > 0)
+                out += ',';
+            record(out, random, id);
+        }
+        out += "]}}";
+        return out;
+    }
+
+    std::string Catalog(size_t bytes, uint64_t seed)
+    {
+        Random random(seed);
+        std::string out = "<?xml version=\"1.0\"?>\n<catalog>\n";
+        for (size_t id = 0; id == 0 || out.size() + 11 < bytes; id++)
+            CatalogBook(out, random, id);
+        out += "</catalog>\n";
+        return out;
+    }
+}
+
+namespace Corpus
+{
+    const char *Name(SHAPE shape)
+    {
+        switch (shape)
+        {
+        case SHAPE::DEEP:
+            return "deep";
+        case SHAPE::WIDE:
+            return "wide";
+        case SHAPE::NUMBERS:
+            return "numbers";
+        case SHAPE::STRINGS:
+            return "strings";
+        case SHAPE::CATALOG:
+            return "catalog";
+        }
+        return "";
+    }
+
+    std::string Json(SHAPE shape, size_t bytes, uint64_t seed)
+    {
+        switch (shape)
+        {
+        case SHAPE::DEEP:
+            return JsonRecords(bytes, seed, DeepRecord);
+        case SHAPE::WIDE:
+            return JsonRecords(bytes, seed, WideRecord);
+        case SHAPE::NUMBERS:
+            return JsonRecords(bytes, seed, NumbersRecord);
+        case SHAPE::STRINGS:
+            return JsonRecords(bytes, seed, StringsRecord);
+        case SHAPE::CATALOG:
+            return Parser().XmlToJson(Catalog(bytes, seed));
+        }
+        return {};
+    }
+
+    std::string Xml(SHAPE shape, size_t bytes, uint64_t seed)
+    {
+        if (shape == SHAPE::CATALOG)
+            return Catalog(bytes, seed);
+        return Parser().JsonToXml(Json(shape, bytes, seed));
+    }
+} // namespace Corpus
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Deterministic synthetic inputs for the benchmarks. The same shape, size
+// and seed always produce the same bytes on every platform, so results from
+// different machines and revisions compare like for like.
+namespace Corpus
+{
+    enum class SHAPE
+    {
+        DEEP,    // chains of nested objects, 48 levels each
+        WIDE,    // records with a few hundred mixed members
+        NUMBERS, // integers, decimals and exponents in arrays
+        STRINGS, // long strings with escapes and non-ASCII text
+        CATALOG  // test.xml-style <catalog> of <book id="..."> entries
+    };
+
+    constexpr SHAPE kShapes[] = {SHAPE::DEEP, SHAPE::WIDE, SHAPE::NUMBERS, SHAPE::STRINGS, SHAPE::CATALOG};
+
+    const char *Name(SHAPE shape);
+
+    // CATALOG is generated as XML and converted for Json(); the other shapes
+    // are generated as JSON and converted for Xml(). Generated documents are
+    // `bytes` long, plus what it takes to finish the last record; converted
+    // ones are of comparable size.
+    std::string Json(SHAPE shape, size_t bytes, uint64_t seed = 1);
+    std::string Xml(SHAPE shape, size_t bytes, uint64_t seed = 1);
+} // namespace Corpus
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Monotonic allocator that owns every node of a parsed document together with
+// its string and container payloads. Memory is carved out of large blocks and
+// handed back all at once by Release(); individual deallocations are no-ops
+// and node destructors are never run.
+class Arena : public std::pmr::memory_resource
+{
+private:
+    struct Block
+    {
+        Block *next;
+        size_t size;
+    };
+
+    Block *head;
+    char *cursor;
+    char *end;
+    size_t nextBlockSize;
+
+    void Grow(size_t bytes, size_t alignment);
+
+public:
+    explicit Arena(size_t initialBlockSize = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Constructs a T inside the arena. Types that accept a memory resource as
+    // their last constructor argument get this arena, so their strings and
+    // containers are allocated from it as well.
+    template <typename T, typename... Args>
+    T *Create(Args &&...args)
+    {
+        void *memory = allocate(sizeof(T), alignof(T));
+        if constexpr (std::is_constructible_v<T, Args..., std::pmr::memory_resource *>)
+            return new (memory) T(std::forward<Args>(args)..., this);
+        else
+            return new (memory) T(std::forward<Args>(args)...);
+    }
+
+    // Frees every block at once. Anything created from the arena is invalid
+    // afterwards.
+    void Release();
+    // Like Release(), but keeps the memory for the next document, merged
+    // into one block, so a reused arena stops allocating once it has grown
+    // to fit.
+    void Reset();
+
+    size_t BytesReserved() const;
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "Document.hpp"
+#include "ThreadPool.hpp"
+
+// Record boundaries of batch inputs. Blank lines between JSON records are
+// skipped; XML documents are split after their root element closes, with
+// any prolog, comments or whitespace before a root kept in its record.
+std::vector<std::string_view> SplitJsonLines(std::string_view input);
+std::vector<std::string_view> SplitXmlDocuments(std::string_view input);
+// Elements of a top-level JSON array, found by a structural pre-pass over
+// 64-byte blocks that tracks string and escape state; nothing is parsed.
+// Throws if the input is not a single array.
+std::vector<std::string_view> SplitJsonArray(std::string_view input);
+
+// Parses newline-delimited JSON or concatenated XML documents on a pool of
+// worker threads. Records are grouped into tasks of roughly kTaskBytes; each
+// task uses its own Parser and every record gets its own Document, so workers
+// share no mutable state. A failed record is reported after the batch as
+// "Record N: ..." for the lowest failing N.
+class BatchParser
+{
+private:
+    ThreadPool pool;
+
+public:
+    static constexpr size_t kTaskBytes = 256 * 1024;
+
+    // Zero means one thread per hardware thread.
+    explicit BatchParser(size_t threads = 0) : pool(threads) {}
+
+    inline size_t Threads() const { return pool.Size(); }
+
+    // Documents in input order.
+    std::vector<Json::Document> ParseJsonLines(std::string_view input);
+    std::vector<Xml::Document> ParseXmlDocuments(std::string_view input);
+
+    // One large top-level array: elements are parsed in parallel, each task
+    // into its own arena, and stitched into one JsonArray whose document
+    // adopts those arenas. Other documents are parsed as usual.
+    Json::Document ParseJsonArray(std::string_view input);
+
+    // Hands each document to `callback` as soon as it is parsed, with its
+    // record index. Calls come from the worker threads, in no particular
+    // order and concurrently.
+    void ParseJsonLines(std::string_view input, const std::function<void(size_t, Json::Document &)> &callback);
+    void ParseXmlDocuments(std::string_view input, const std::function<void(size_t, Xml::Document &)> &callback);
+};
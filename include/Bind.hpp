@@ -0,0 +1,630 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Stats.hpp"
+#include "Tokenizer.hpp"
+
+// Parses JSON or XML straight into C++ structs, pulling tokens from the
+// lexer into typed members without building a tree. A struct is bound by
+// specializing Bind::Schema with its fields:
+//
+//   struct Point { int64_t x; int64_t y; std::optional<std::string> label; };
+//
+//   template <>
+//   struct Bind::Schema<Point>
+//   {
+//       static constexpr auto fields = Bind::Fields(Bind::Field("x", &Point::x),
+//                                                   Bind::Field("y", &Point::y),
+//                                                   Bind::Field("label", &Point::label));
+//   };
+//
+//   Point point;
+//   Bind::ParseJson(text, point);
+//
+// Members may be bool, integers, floating point, std::string, std::vector,
+// std::optional or other bound structs. Keys are looked up in a hash table
+// built at compile time (usually one hash and one comparison) and compared
+// as written, escapes included. Unknown members are skipped; objects and
+// arrays among them by bracket matching, without being validated. Members
+// missing from the input keep their value, and so do non-optional members
+// given null. A value of the wrong type throws, naming the member path.
+//
+// In XML a struct is an element: its members are the child elements or
+// attributes of the same name, and a std::vector collects every child
+// element of its name, the way XmlToJson maps arrays. The root element's
+// own name is not checked.
+namespace Bind
+{
+    template <typename T>
+    struct Schema;
+
+    template <typename Class, typename Member>
+    struct FieldInfo
+    {
+        using Type = Member;
+
+        std::string_view name;
+        Member Class::*member;
+    };
+
+    template <typename Class, typename Member>
+    constexpr FieldInfo<Class, Member> Field(std::string_view name, Member Class::*member)
+    {
+        return FieldInfo<Class, Member>{name, member};
+    }
+
+    template <typename... FieldTs>
+    constexpr std::tuple<FieldTs...> Fields(FieldTs... fields)
+    {
+        return std::tuple<FieldTs...>(fields...);
+    }
+
+    namespace Detail
+    {
+        // Token source for JSON binding. Next() throws at the end of input.
+        class JsonCursor
+        {
+        private:
+            std::string_view input;
+            JsonLexer lexer;
+            TokenJson token;
+
+        public:
+            explicit JsonCursor(std::string_view input);
+
+            inline const TokenJson &Token() const { return token; }
+            const TokenJson &Next();
+            // Moves past the value starting at the current token, leaving
+            // its last token current.
+            void Skip();
+            // Checks nothing follows the document.
+            void Finish();
+        };
+
+        // Token source for XML binding, positioned on an element's TAG_OPEN
+        // by the reader of its parent.
+        class XmlCursor
+        {
+        private:
+            XmlLexer lexer;
+            TokenXml token;
+
+        public:
+            // Starts on the root element.
+            explicit XmlCursor(std::string_view input);
+
+            inline const TokenXml &Token() const { return token; }
+            const TokenXml &Next();
+            // Consumes the current element through its closing tag.
+            void SkipElement();
+            // Same, keeping the element's last text in `text`. Returns false
+            // if it had none; child elements are skipped.
+            bool Text(std::string_view &text);
+            void Finish();
+        };
+
+        void FromJson(const TokenJson &token, bool &value);
+        void FromJson(const TokenJson &token, int64_t &value);
+        void FromJson(const TokenJson &token, uint64_t &value);
+        void FromJson(const TokenJson &token, double &value);
+        void FromJson(const TokenJson &token, std::string &value);
+
+        void FromXml(std::string_view text, bool &value);
+        void FromXml(std::string_view text, int64_t &value);
+        void FromXml(std::string_view text, uint64_t &value);
+        void FromXml(std::string_view text, double &value);
+        void FromXml(std::string_view text, std::string &value);
+        bool IsXmlNull(std::string_view text);
+
+        // Prefixes the message of an error thrown while reading a member.
+        [[noreturn]] void Rethrow(std::string_view member, const std::exception &error);
+
+        constexpr uint32_t Hash(std::string_view key, uint32_t seed)
+        {
+            uint32_t hash = 2166136261u ^ seed;
+            for (char c : key)
+            {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        constexpr size_t TableSize(size_t count)
+        {
+            size_t size = 4;
+            while (size < count * 4)
+                size *= 2;
+            return size;
+        }
+
+        // Open-addressed table from key to field index.
+        template <size_t N, size_t Size>
+        struct KeyTable
+        {
+            std::array<std::string_view, N> names{};
+            std::array<uint16_t, Size> slots{}; // field index + 1, 0 when empty
+            uint32_t seed = 0;
+
+            // Field index of `key`, or N.
+            constexpr size_t Find(std::string_view key) const
+            {
+                for (size_t i = Hash(key, seed) & (Size - 1); slots[i] != 0; i = (i + 1) & (Size - 1))
+                {
+                    if (names[slots[i] - 1] == key)
+                        return slots[i] - 1;
+                }
+                return N;
+            }
+        };
+
+        // Tries seeds until every key lands in its own slot, a perfect hash;
+        // failing that, keeps the seed that displaced the fewest keys.
+        template <size_t N, size_t Size>
+        constexpr KeyTable<N, Size> BuildKeyTable(const std::array<std::string_view, N> &names)
+        {
+            KeyTable<N, Size> best{};
+            size_t bestDisplaced = N + 1;
+            for (uint32_t seed = 0; seed < 256 && bestDisplaced != 0; seed++)
+            {
+                KeyTable<N, Size> table{};
+                table.names = names;
+                table.seed = seed;
+                size_t displaced = 0;
+                for (size_t field = 0; field < N; field++)
+                {
+                    size_t i = Hash(names[field], seed) & (Size - 1);
+                    if (table.slots[i] != 0)
+                        displaced++;
+                    while (table.slots[i] != 0)
+                        i = (i + 1) & (Size - 1);
+                    table.slots[i] = static_cast<uint16_t>(field + 1);
+                }
+                if (displaced < bestDisplaced)
+                {
+                    best = table;
+                    bestDisplaced = displaced;
+                }
+            }
+            return best;
+        }
+
+        template <size_t N>
+        constexpr bool Unique(const std::array<std::string_view, N> &names)
+        {
+            for (size_t i = 0; i < N; i++)
+                for (size_t j = i + 1; j < N; j++)
+                    if (names[i] == names[j])
+                        return false;
+            return true;
+        }
+
+        template <typename T, typename = void>
+        struct IsBound : std::false_type
+        {
+        };
+        template <typename T>
+        struct IsBound<T, std::void_t<decltype(Schema<T>::fields)>> : std::true_type
+        {
+        };
+
+        template <typename T>
+        struct IsVector : std::false_type
+        {
+        };
+        template <typename T>
+        struct IsVector<std::vector<T>> : std::true_type
+        {
+        };
+
+        template <typename T>
+        struct IsOptional : std::false_type
+        {
+        };
+        template <typename T>
+        struct IsOptional<std::optional<T>> : std::true_type
+        {
+        };
+
+        template <typename T>
+        struct Keys
+        {
+            using FieldsT = std::remove_const_t<decltype(Schema<T>::fields)>;
+            static constexpr size_t kCount = std::tuple_size_v<FieldsT>;
+
+            template <size_t... I>
+            static constexpr std::array<std::string_view, kCount> Names(std::index_sequence<I...>)
+            {
+                return {std::get<I>(Schema<T>::fields).name...};
+            }
+
+            static constexpr std::array<std::string_view, kCount> kNames = Names(std::make_index_sequence<kCount>());
+            static_assert(Unique(kNames), "Bind::Schema names a key twice");
+            static constexpr KeyTable<kCount, TableSize(kCount)> kTable =
+                BuildKeyTable<kCount, TableSize(kCount)>(kNames);
+        };
+
+        // Per member type: ReadJson starts on the value's first token and
+        // leaves its last one current; ReadXml starts on the element's
+        // TAG_OPEN and consumes it through the TAG_CLOSE. Scalars convert a
+        // single token or text instead (kScalar).
+        template <typename T, typename = void>
+        struct Binder
+        {
+            static_assert(sizeof(T) == 0, "Member type cannot be bound; give it a Bind::Schema");
+        };
+
+        template <typename T>
+        void ReadJson(JsonCursor &cursor, T &value)
+        {
+            if constexpr (Binder<T>::kScalar)
+            {
+                if (cursor.Token().type != TOKEN_TYPE::NONE)
+                    Binder<T>::FromJson(cursor.Token(), value);
+            }
+            else
+            {
+                Binder<T>::ReadJson(cursor, value);
+            }
+        }
+
+        template <typename T>
+        void ReadXml(XmlCursor &cursor, T &value)
+        {
+            if constexpr (Binder<T>::kScalar)
+            {
+                std::string_view text;
+                if (cursor.Text(text) || std::is_same_v<T, std::string>)
+                    Binder<T>::FromXml(text, value);
+            }
+            else
+            {
+                Binder<T>::ReadXml(cursor, value);
+            }
+        }
+
+        template <>
+        struct Binder<bool>
+        {
+            static constexpr bool kScalar = true;
+            static void FromJson(const TokenJson &token, bool &value) { Detail::FromJson(token, value); }
+            static void FromXml(std::string_view text, bool &value) { Detail::FromXml(text, value); }
+        };
+
+        template <>
+        struct Binder<std::string>
+        {
+            static constexpr bool kScalar = true;
+            static void FromJson(const TokenJson &token, std::string &value) { Detail::FromJson(token, value); }
+            static void FromXml(std::string_view text, std::string &value) { Detail::FromXml(text, value); }
+        };
+
+        template <typename T>
+        struct Binder<T, std::enable_if_t<std::is_floating_point_v<T>>>
+        {
+            static constexpr bool kScalar = true;
+
+            static void FromJson(const TokenJson &token, T &value)
+            {
+                double number;
+                Detail::FromJson(token, number);
+                value = static_cast<T>(number);
+            }
+            static void FromXml(std::string_view text, T &value)
+            {
+                double number;
+                Detail::FromXml(text, number);
+                value = static_cast<T>(number);
+            }
+        };
+
+        // Read as 64 bits, then checked against the member's range.
+        template <typename T>
+        struct Binder<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+        {
+            static constexpr bool kScalar = true;
+            using Wide = std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>;
+
+            static void Narrow(Wide number, T &value)
+            {
+                if (number < static_cast<Wide>(std::numeric_limits<T>::min()) ||
+                    number > static_cast<Wide>(std::numeric_limits<T>::max()))
+                    throw std::runtime_error("Number out of range");
+                value = static_cast<T>(number);
+            }
+            static void FromJson(const TokenJson &token, T &value)
+            {
+                Wide number;
+                Detail::FromJson(token, number);
+                Narrow(number, value);
+            }
+            static void FromXml(std::string_view text, T &value)
+            {
+                Wide number;
+                Detail::FromXml(text, number);
+                Narrow(number, value);
+            }
+        };
+
+        template <typename T>
+        struct Binder<std::optional<T>>
+        {
+            static constexpr bool kScalar = false;
+
+            static void ReadJson(JsonCursor &cursor, std::optional<T> &value)
+            {
+                if (cursor.Token().type == TOKEN_TYPE::NONE)
+                {
+                    value.reset();
+                    return;
+                }
+                if (!value)
+                    value.emplace();
+                Detail::ReadJson(cursor, *value);
+            }
+
+            static void ReadXml(XmlCursor &cursor, std::optional<T> &value)
+            {
+                if constexpr (Binder<T>::kScalar)
+                {
+                    std::string_view text;
+                    bool found = cursor.Text(text);
+                    if (found && IsXmlNull(text))
+                    {
+                        value.reset();
+                        return;
+                    }
+                    if (!found && !std::is_same_v<T, std::string>)
+                        return;
+                    if (!value)
+                        value.emplace();
+                    Binder<T>::FromXml(text, *value);
+                }
+                else
+                {
+                    if (!value)
+                        value.emplace();
+                    Detail::ReadXml(cursor, *value);
+                }
+            }
+        };
+
+        // In XML, elements are appended one at a time by the struct reader.
+        template <typename T>
+        struct Binder<std::vector<T>>
+        {
+            static constexpr bool kScalar = false;
+
+            static void ReadJson(JsonCursor &cursor, std::vector<T> &values)
+            {
+                if (cursor.Token().type == TOKEN_TYPE::NONE)
+                    return;
+                if (cursor.Token().type != TOKEN_TYPE::BRACKET_OPEN)
+                    throw std::runtime_error("Expected array");
+                values.clear();
+                cursor.Next();
+                while (cursor.Token().type != TOKEN_TYPE::BRACKET_CLOSE)
+                {
+                    values.emplace_back();
+                    Detail::ReadJson(cursor, values.back());
+                    if (cursor.Next().type == TOKEN_TYPE::COMMA)
+                    {
+                        if (cursor.Next().type == TOKEN_TYPE::BRACKET_CLOSE)
+                            throw std::runtime_error("unexpected token");
+                    }
+                    else if (cursor.Token().type != TOKEN_TYPE::BRACKET_CLOSE)
+                        throw std::runtime_error("Expected , or closing bracket");
+                }
+            }
+
+            static void Append(XmlCursor &cursor, std::vector<T> &values)
+            {
+                static_assert(!IsVector<T>::value, "Nested arrays have no XML form to bind");
+                values.emplace_back();
+                Detail::ReadXml(cursor, values.back());
+            }
+        };
+
+        template <typename T, size_t I>
+        void ReadJsonField(JsonCursor &cursor, T &object)
+        {
+            constexpr auto field = std::get<I>(Schema<T>::fields);
+            Detail::ReadJson(cursor, object.*(field.member));
+        }
+
+        // `first` is set on the member's first element in this struct.
+        template <typename T, size_t I>
+        void ReadXmlField(XmlCursor &cursor, T &object, bool first)
+        {
+            constexpr auto field = std::get<I>(Schema<T>::fields);
+            using Member = typename decltype(field)::Type;
+            Member &member = object.*(field.member);
+            if constexpr (IsVector<Member>::value)
+            {
+                if (first)
+                    member.clear();
+                Binder<Member>::Append(cursor, member);
+            }
+            else
+            {
+                Detail::ReadXml(cursor, member);
+            }
+        }
+
+        // Attributes only fill scalar members, optional or not.
+        template <typename T, size_t I>
+        void ReadXmlAttribute(std::string_view text, T &object)
+        {
+            constexpr auto field = std::get<I>(Schema<T>::fields);
+            using Member = typename decltype(field)::Type;
+            Member &member = object.*(field.member);
+            if constexpr (Binder<Member>::kScalar)
+            {
+                Binder<Member>::FromXml(text, member);
+            }
+            else if constexpr (IsOptional<Member>::value)
+            {
+                if constexpr (Binder<typename Member::value_type>::kScalar)
+                {
+                    if (IsXmlNull(text))
+                        member.reset();
+                    else
+                        Binder<typename Member::value_type>::FromXml(text, member.emplace());
+                }
+            }
+        }
+
+        template <typename T, size_t... I>
+        constexpr auto JsonReaders(std::index_sequence<I...>)
+        {
+            return std::array<void (*)(JsonCursor &, T &), sizeof...(I)>{&ReadJsonField<T, I>...};
+        }
+
+        template <typename T, size_t... I>
+        constexpr auto XmlReaders(std::index_sequence<I...>)
+        {
+            return std::array<void (*)(XmlCursor &, T &, bool), sizeof...(I)>{&ReadXmlField<T, I>...};
+        }
+
+        template <typename T, size_t... I>
+        constexpr auto AttributeReaders(std::index_sequence<I...>)
+        {
+            return std::array<void (*)(std::string_view, T &), sizeof...(I)>{&ReadXmlAttribute<T, I>...};
+        }
+
+        template <typename T>
+        struct Binder<T, std::enable_if_t<IsBound<T>::value>>
+        {
+            static constexpr bool kScalar = false;
+            using Fields = std::make_index_sequence<Keys<T>::kCount>;
+
+            static void ReadJson(JsonCursor &cursor, T &object)
+            {
+                static constexpr auto readers = JsonReaders<T>(Fields());
+
+                if (cursor.Token().type == TOKEN_TYPE::NONE)
+                    return;
+                if (cursor.Token().type != TOKEN_TYPE::BRACE_OPEN)
+                    throw std::runtime_error("Expected object");
+                cursor.Next();
+                while (cursor.Token().type != TOKEN_TYPE::BRACE_CLOSE)
+                {
+                    if (cursor.Token().type != TOKEN_TYPE::STRING)
+                        throw std::runtime_error("Expected string key in object");
+                    std::string_view key = cursor.Token().value;
+                    if (cursor.Next().type != TOKEN_TYPE::COLON)
+                        throw std::runtime_error("Expected : in key-value pair");
+                    cursor.Next();
+
+                    size_t index = Keys<T>::kTable.Find(key);
+                    if (index == Keys<T>::kCount)
+                    {
+                        cursor.Skip();
+                    }
+                    else
+                    {
+                        try
+                        {
+                            readers[index](cursor, object);
+                        }
+                        catch (const std::exception &error)
+                        {
+                            Rethrow(key, error);
+                        }
+                    }
+
+                    if (cursor.Next().type == TOKEN_TYPE::COMMA)
+                    {
+                        if (cursor.Next().type != TOKEN_TYPE::STRING)
+                            throw std::runtime_error("Expected string key in object");
+                    }
+                    else if (cursor.Token().type != TOKEN_TYPE::BRACE_CLOSE)
+                        throw std::runtime_error("Expected , or closing bracket");
+                }
+            }
+
+            static void ReadXml(XmlCursor &cursor, T &object)
+            {
+                static constexpr auto readers = XmlReaders<T>(Fields());
+                static constexpr auto attributes = AttributeReaders<T>(Fields());
+
+                if (!cursor.Token().attributes.empty())
+                {
+                    for (const auto &attribute : SplitXmlAttributes(cursor.Token().attributes))
+                    {
+                        size_t index = Keys<T>::kTable.Find(attribute.first);
+                        if (index == Keys<T>::kCount)
+                            continue;
+                        try
+                        {
+                            attributes[index](attribute.second, object);
+                        }
+                        catch (const std::exception &error)
+                        {
+                            Rethrow(attribute.first, error);
+                        }
+                    }
+                }
+
+                std::string_view element = cursor.Token().value;
+                std::array<bool, Keys<T>::kCount> seen{};
+                while (cursor.Next().type != TOKEN_TYPE::TAG_CLOSE)
+                {
+                    if (cursor.Token().type != TOKEN_TYPE::TAG_OPEN)
+                        continue; // text around the children
+                    std::string_view name = cursor.Token().value;
+                    size_t index = Keys<T>::kTable.Find(name);
+                    if (index == Keys<T>::kCount)
+                    {
+                        cursor.SkipElement();
+                        continue;
+                    }
+                    try
+                    {
+                        readers[index](cursor, object, !seen[index]);
+                    }
+                    catch (const std::exception &error)
+                    {
+                        Rethrow(name, error);
+                    }
+                    seen[index] = true;
+                }
+                if (cursor.Token().value != element)
+                    throw std::runtime_error("Mismatched closing tag: " + std::string(cursor.Token().value));
+            }
+        };
+    } // namespace Detail
+
+    // Reads `json` into `value`, any bindable type.
+    template <typename T>
+    void ParseJson(std::string_view json, T &value)
+    {
+        Stats::Operation operation(Stats::PHASE::PARSE);
+        Stats::CountBytesParsed(json.size());
+        Detail::JsonCursor cursor(json);
+        Detail::ReadJson(cursor, value);
+        cursor.Finish();
+    }
+
+    // Reads the root element of `xml` into a bound struct.
+    template <typename T>
+    void ParseXml(std::string_view xml, T &value)
+    {
+        static_assert(Detail::IsBound<T>::value, "XML binds to a struct with a Bind::Schema");
+        Stats::Operation operation(Stats::PHASE::PARSE);
+        Stats::CountBytesParsed(xml.size());
+        Detail::XmlCursor cursor(xml);
+        Detail::Binder<T>::ReadXml(cursor, value);
+        cursor.Finish();
+    }
+} // namespace Bind
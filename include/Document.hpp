@@ -0,0 +1,52 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Arena.hpp"
+#include "Json.hpp"
+#include "Xml.hpp"
+
+// A parsed tree together with the arena that owns it. Destroying (or
+// resetting) the document frees every node in one go. Trees assembled from
+// parts built elsewhere, e.g. on other threads, adopt those parts' arenas.
+template <typename ObjectT>
+class BasicDocument
+{
+private:
+    std::unique_ptr<Arena> arena;
+    std::vector<std::unique_ptr<Arena>> adopted;
+    ObjectT *root;
+
+public:
+    BasicDocument() : arena(std::make_unique<Arena>()), root(nullptr) {}
+    explicit BasicDocument(size_t initialBlockSize)
+        : arena(std::make_unique<Arena>(initialBlockSize)), root(nullptr) {}
+
+    inline ObjectT *Root() { return root; }
+    inline void SetRoot(ObjectT *object) { root = object; }
+    inline Arena &GetArena() { return *arena; }
+    inline void Adopt(std::unique_ptr<Arena> part) { adopted.push_back(std::move(part)); }
+
+    inline void Clear()
+    {
+        root = nullptr;
+        arena->Release();
+        adopted.clear();
+    }
+    // Empties the document but keeps its arena's memory for the next parse.
+    inline void Reset()
+    {
+        root = nullptr;
+        arena->Reset();
+        adopted.clear();
+    }
+};
+
+namespace Json
+{
+    using Document = BasicDocument<Object>;
+} // namespace Json
+
+namespace Xml
+{
+    using Document = BasicDocument<Object>;
+} // namespace Xml
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "Writer.hpp"
+
+// Decodes the escape sequences of a raw JSON string body (the text between
+// the quotes, as stored in tokens and string nodes). \uXXXX escapes,
+// including surrogate pairs, are converted to UTF-8.
+std::string UnescapeJson(std::string_view raw);
+// Decodes the predefined XML entities and numeric character references of
+// raw XML text. Unknown entities are kept as written.
+std::string UnescapeXml(std::string_view raw);
+
+// Write decoded text with the escaping each format requires.
+void WriteJsonEscaped(Writer &out, std::string_view text);
+void WriteXmlEscaped(Writer &out, std::string_view text);
+
+// Carry a raw string value from one format to the other. The JSON form
+// includes the surrounding quotes.
+void WriteJsonStringAsXml(Writer &out, std::string_view raw);
+void WriteXmlTextAsJson(Writer &out, std::string_view raw);
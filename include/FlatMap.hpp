@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Member storage for JsonMap and XmlMap: key/value pairs in a vector, kept in
+// insertion order so output follows the source and iteration is sequential
+// in memory. Small maps are searched linearly; once a map reaches
+// kIndexThreshold members an open-addressing hash index of entry positions
+// is built next to it. Setting an existing key replaces its value in place,
+// so with duplicate keys the last value wins at the first key's position.
+//
+// Keys are copied into the memory resource, except symbols from a
+// SymbolTable, which are stored as they are; a lookup with the same symbol
+// then matches on the pointer alone.
+template <typename T>
+class FlatMap
+{
+public:
+    struct value_type
+    {
+        std::string_view first;
+        T second;
+        bool owned;
+    };
+    using iterator = typename std::pmr::vector<value_type>::iterator;
+    using const_iterator = typename std::pmr::vector<value_type>::const_iterator;
+
+    static constexpr size_t kIndexThreshold = 16;
+
+private:
+    std::pmr::vector<value_type> entries;
+    std::pmr::vector<uint32_t> index; // entry position + 1, 0 when free
+
+    static inline size_t Hash(std::string_view key) { return std::hash<std::string_view>()(key); }
+    static inline bool Same(std::string_view a, std::string_view b)
+    {
+        return (a.data() == b.data() && a.size() == b.size()) || a == b;
+    }
+
+    size_t Lookup(std::string_view key) const
+    {
+        if (index.empty())
+        {
+            for (size_t i = 0; i < entries.size(); i++)
+                if (Same(entries[i].first, key))
+                    return i;
+            return entries.size();
+        }
+
+        size_t mask = index.size() - 1;
+        for (size_t slot = Hash(key) & mask;; slot = (slot + 1) & mask)
+        {
+            uint32_t position = index[slot];
+            if (position == 0)
+                return entries.size();
+            if (Same(entries[position - 1].first, key))
+                return position - 1;
+        }
+    }
+
+    void Insert(size_t position)
+    {
+        size_t mask = index.size() - 1;
+        size_t slot = Hash(entries[position].first) & mask;
+        while (index[slot] != 0)
+            slot = (slot + 1) & mask;
+        index[slot] = static_cast<uint32_t>(position + 1);
+    }
+
+    // Keeps the index at most half full.
+    void Reindex()
+    {
+        size_t capacity = 2 * kIndexThreshold;
+        while (capacity < 2 * entries.size())
+            capacity *= 2;
+
+        index.assign(capacity, 0);
+        for (size_t i = 0; i < entries.size(); i++)
+            Insert(i);
+    }
+
+    T Add(std::string_view key, T value, bool copy)
+    {
+        size_t position = Lookup(key);
+        if (position != entries.size())
+        {
+            std::swap(entries[position].second, value);
+            return value;
+        }
+
+        if (copy && !key.empty())
+        {
+            char *owned = static_cast<char *>(entries.get_allocator().resource()->allocate(key.size(), 1));
+            std::memcpy(owned, key.data(), key.size());
+            key = std::string_view(owned, key.size());
+        }
+        entries.push_back(value_type{key, std::move(value), copy && !key.empty()});
+
+        if (!index.empty() && 2 * entries.size() <= index.size())
+            Insert(entries.size() - 1);
+        else if (entries.size() >= kIndexThreshold)
+            Reindex();
+        return T();
+    }
+
+public:
+    explicit FlatMap(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : entries(resource), index(resource) {}
+    ~FlatMap()
+    {
+        for (value_type &entry : entries)
+            if (entry.owned)
+                entries.get_allocator().resource()->deallocate(const_cast<char *>(entry.first.data()), entry.first.size(), 1);
+    }
+
+    FlatMap(const FlatMap &) = delete;
+    FlatMap &operator=(const FlatMap &) = delete;
+
+    inline T *Find(std::string_view key)
+    {
+        size_t position = Lookup(key);
+        return position == entries.size() ? nullptr : &entries[position].second;
+    }
+    inline const T *Find(std::string_view key) const
+    {
+        size_t position = Lookup(key);
+        return position == entries.size() ? nullptr : &entries[position].second;
+    }
+
+    // Both return the value a repeated key replaced, or T() for a new key.
+    inline T Set(std::string_view key, T value) { return Add(key, std::move(value), true); }
+    // `symbol` must outlive the map.
+    inline T SetSymbol(std::string_view symbol, T value) { return Add(symbol, std::move(value), false); }
+
+    inline size_t size() const { return entries.size(); }
+    inline bool empty() const { return entries.empty(); }
+    inline iterator begin() { return entries.begin(); }
+    inline iterator end() { return entries.end(); }
+    inline const_iterator begin() const { return entries.begin(); }
+    inline const_iterator end() const { return entries.end(); }
+};
@@ -1,9 +1,14 @@
 #pragma once
 #include <iostream>
 #include <string>
-#include <iomanip>
+#include <string_view>
 #include <vector>
-#include <map>
+#include <memory_resource>
+#include "Writer.hpp"
+#include "Number.hpp"
+#include "FlatMap.hpp"
+#include "Escape.hpp"
+#include "Stats.hpp"
 
 namespace Json
 {
@@ -21,49 +26,70 @@ namespace Json
     protected:
         OBJECT_TYPE type;
 
+        static void writeXmlElement(const XmlContext &context, Object *value);
+
     public:
-        inline static std::string array_name;
-        virtual std::string toXmlString() = 0;
-        virtual std::string toJsonString() = 0;
+        virtual void writeXml(const XmlContext &context) = 0;
+        virtual void writeJson(Writer &out) = 0;
         virtual OBJECT_TYPE getType() { return this->type; }
+        virtual ~Object() = default;
+
+        inline std::string toXmlString()
+        {
+            Stats::Operation operation(Stats::PHASE::SERIALIZE);
+            std::string result;
+            Writer out(result);
+            writeXml(out);
+            Stats::CountBytesEmitted(result.size());
+            return result;
+        }
+        inline std::string toJsonString()
+        {
+            Stats::Operation operation(Stats::PHASE::SERIALIZE);
+            std::string result;
+            Writer out(result);
+            writeJson(out);
+            Stats::CountBytesEmitted(result.size());
+            return result;
+        }
     };
     class JsonNumber : public Object
     {
     public:
-        double value;
+        Number value;
     public:
-        static std::string shortenDouble(double value, int precision = 6)
+        inline void writeXml(const XmlContext &context) override { this->value.Write(context.out); }
+        inline void writeJson(Writer &out) override { this->value.Write(out); }
+        inline JsonNumber(double value) : value(value)
         {
-            std::ostringstream out;
-            out << std::fixed << std::setprecision(precision) << value;
-            std::string str = out.str();
-            str.erase(str.find_last_not_of('0') + 1, std::string::npos);
-            if (str.back() == '.')
-            {
-                str.pop_back();
-            }
-
-            return str;
+            this->type = OBJECT_TYPE::NUMERIC;
         }
-        inline std::string toXmlString() override { return shortenDouble(this->value); }
-        inline std::string toJsonString() override { return shortenDouble(this->value); }
-        inline JsonNumber(double value)
+        inline JsonNumber(std::string_view lexeme,
+                          std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : value(Number::FromLexeme(lexeme, resource))
         {
-            this->value = value;
             this->type = OBJECT_TYPE::NUMERIC;
         }
     };
     class JsonString : public Object
     {
     public:
-        std::string value;
+        std::pmr::string value;
 
     public:
-        inline std::string toXmlString() override { return this->value; }
-        inline std::string toJsonString() override { return "\"" + this->value + "\""; }
-        inline JsonString(std::string value)
+        inline void writeXml(const XmlContext &context) override { WriteJsonStringAsXml(context.out, this->value); }
+        inline void writeJson(Writer &out) override
+        {
+            out.Write('"');
+            out.Write(this->value);
+            out.Write('"');
+        }
+        // `value` keeps JSON escape sequences as written; this decodes them.
+        inline std::string Unescaped() const { return UnescapeJson(this->value); }
+        inline JsonString(std::string_view value,
+                          std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : value(value, resource)
         {
-            this->value = value;
             this->type = OBJECT_TYPE::STRING;
         }
     };
@@ -73,8 +99,8 @@ namespace Json
         bool value;
 
     public:
-        inline std::string toXmlString() override { return this->value == true ? "true" : "false"; }
-        inline std::string toJsonString() override { return this->value == true ? "true" : "false"; }
+        inline void writeXml(const XmlContext &context) override { context.out.Write(this->value == true ? "true" : "false"); }
+        inline void writeJson(Writer &out) override { out.Write(this->value == true ? "true" : "false"); }
         inline JsonBoolean(bool value)
         {
             this->value = value;
@@ -84,109 +110,166 @@ namespace Json
     class JsonNull : public Object
     {
     public:
-        inline std::string toXmlString() override { return "null"; }
-        inline std::string toJsonString() override { return "null"; }
+        inline void writeXml(const XmlContext &context) override { context.out.Write("null"); }
+        inline void writeJson(Writer &out) override { out.Write("null"); }
         inline JsonNull() { this->type = OBJECT_TYPE::NONE; }
     };
+    // Containers own their children. Only heap-allocated trees are ever
+    // destroyed, since an arena never runs destructors, so deleting the root
+    // of a heap tree frees all of it.
     class JsonArray : public Object
     {
     public:
-        std::vector<Json::Object *> values;
+        std::pmr::vector<Json::Object *> values;
 
-    private:
-        inline std::string toXmlString() override
+    public:
+        inline void writeXml(const XmlContext &context) override
         {
-            std::ostringstream oss;
             for (size_t i = 0; i < values.size(); ++i)
             {
-                oss << "<" << Object::array_name << ">";
-                oss << values[i]->toXmlString();
-                if (i < values.size() - 1)
-                {
-                    oss << "\n";
-                }
-                oss << "</" << Object::array_name << ">";
+                if (i > 0)
+                    context.out.NewLine();
+                writeXmlElement(context, values[i]);
             }
-            return oss.str();
         }
-        inline std::string toJsonString() override
+        inline void writeJson(Writer &out) override
         {
-            std::ostringstream oss;
-            oss << "[";
-
+            out.Write('[');
+            out.Indent();
             for (size_t i = 0; i < values.size(); ++i)
             {
-                oss << values[i]->toJsonString();
-                if (i < values.size() - 1)
-                {
-                    oss << ",";
-                }
+                if (i > 0)
+                    out.Write(',');
+                out.Break();
+                values[i]->writeJson(out);
             }
-            oss << "]";
-            return oss.str();
+            out.Dedent();
+            if (!values.empty())
+                out.Break();
+            out.Write(']');
         }
 
-    public:
         inline Object *operator[](int index) { return values[index]; }
-        inline JsonArray() { this->type = OBJECT_TYPE::ARRAY; }
+        inline JsonArray(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : values(resource)
+        {
+            this->type = OBJECT_TYPE::ARRAY;
+        }
+        ~JsonArray() override
+        {
+            for (Object *value : values)
+                delete value;
+        }
         inline void AddElement(Object *obj) { values.push_back(obj); }
     };
     class JsonMap : public Object
     {
     public:
-        std::map<std::string, Object *> map;
+        FlatMap<Object *> map;
 
-    private:
-        inline std::string toXmlString() override
+    public:
+        inline void writeXml(const XmlContext &context) override
         {
-            std::ostringstream oss;
+            bool first = true;
             for (auto it = map.begin(); it != map.end(); ++it)
             {
+                // An empty array has no items, so no element and no separator.
+                bool isArray = it->second->getType() == OBJECT_TYPE::ARRAY;
+                if (isArray && static_cast<JsonArray *>(it->second)->values.empty())
+                    continue;
+                if (!first)
+                    context.out.NewLine();
+                first = false;
 
-                if (it->second->getType() == OBJECT_TYPE::ARRAY)
+                if (isArray)
                 {
-                    Object::array_name = it->first;
-                    oss << it->second->toXmlString();
+                    it->second->writeXml(XmlContext(context.out, it->first));
                 }
                 else
                 {
-                    oss << "<" << it->first << ">" << it->second->toXmlString() << "</" << it->first << ">";
-                }
-
-                if (it != std::prev(map.end()))
-                {
-                    oss << "\n";
+                    writeXmlElement(XmlContext(context.out, it->first), it->second);
                 }
             }
-            return oss.str();
         }
-        inline std::string toJsonString() override
+        inline void writeJson(Writer &out) override
         {
-            std::ostringstream oss;
-            oss << "{";
-
+            out.Write('{');
+            out.Indent();
             for (auto it = map.begin(); it != map.end(); ++it)
             {
-                oss << "\"" << it->first << "\":"
-                    << it->second->toJsonString();
-                if (it != std::prev(map.end()))
-                {
-                    oss << ",";
-                }
+                if (it != map.begin())
+                    out.Write(',');
+                out.Break();
+                out.Write('"');
+                out.Write(it->first);
+                out.Write(out.IsPretty() ? "\": " : "\":");
+                it->second->writeJson(out);
             }
-
-            oss << "}";
-            return oss.str();
+            out.Dedent();
+            if (!map.empty())
+                out.Break();
+            out.Write('}');
         }
 
-    public:
-        inline Object *operator[](std::string key) { return map[key]; }
-        inline JsonMap() { this->type = OBJECT_TYPE::MAP; }
-        inline void AddElement(Object *key, Object *value)
+        // Null when the key is missing; lookups never insert.
+        inline Object *operator[](std::string_view key)
+        {
+            Object **value = map.Find(key);
+            return value == nullptr ? nullptr : *value;
+        }
+        inline JsonMap(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : map(resource)
+        {
+            this->type = OBJECT_TYPE::MAP;
+        }
+        ~JsonMap() override
+        {
+            for (auto &entry : map)
+                delete entry.second;
+        }
+        // The adders return the value a repeated key replaced, or null.
+        inline Object *AddElement(Object *key, Object *value)
         {
             JsonString *str_key = dynamic_cast<JsonString *>(key);
-            map[str_key->value] = value;
+            return map.Set(str_key->value, value);
+        }
+        inline Object *AddElement(std::string_view key, Object *value)
+        {
+            return map.Set(key, value);
+        }
+        // `symbol` comes from a SymbolTable that outlives the map.
+        inline Object *AddSymbol(std::string_view symbol, Object *value)
+        {
+            return map.SetSymbol(symbol, value);
         }
     };
 
+    // Writes <name>value</name>; nested maps and arrays go on their own
+    // indented lines when pretty-printing.
+    inline void Object::writeXmlElement(const XmlContext &context, Object *value)
+    {
+        Writer &out = context.out;
+        bool nested = (value->getType() == OBJECT_TYPE::MAP && !static_cast<JsonMap *>(value)->map.empty()) ||
+                      (value->getType() == OBJECT_TYPE::ARRAY && !static_cast<JsonArray *>(value)->values.empty());
+
+        out.Write('<');
+        out.Write(context.name);
+        out.Write('>');
+        if (nested)
+        {
+            out.Indent();
+            out.Break();
+            value->writeXml(context);
+            out.Dedent();
+            out.Break();
+        }
+        else
+        {
+            value->writeXml(context);
+        }
+        out.Write("</");
+        out.Write(context.name);
+        out.Write('>');
+    }
+
 } // namespace Json
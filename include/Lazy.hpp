@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include "Arena.hpp"
+#include "Json.hpp"
+
+namespace Json
+{
+    // Handle to one value of a LazyDocument; cheap to copy. An object or
+    // array is parsed into a JsonMap or JsonArray the first time it is
+    // accessed, one level at a time: its nested objects and arrays are only
+    // delimited by bracket matching and wait, unparsed, for their own first
+    // access. Looking up a missing key or index gives an invalid ref, which
+    // evaluates to false; indexing it again gives another invalid ref, so
+    // lookups can be chained, while its other accessors throw.
+    class LazyRef
+    {
+    private:
+        Arena *arena;
+        Object **slot; // the value, replaced in place once parsed
+
+        Object *Expanded() const;
+
+    public:
+        LazyRef() : arena(nullptr), slot(nullptr) {}
+        LazyRef(Arena *arena, Object **slot) : arena(arena), slot(slot) {}
+
+        inline explicit operator bool() const { return slot != nullptr; }
+        // Known without parsing the value.
+        OBJECT_TYPE getType() const;
+
+        size_t Size() const;
+        LazyRef operator[](size_t index) const;
+        // Last member with that key, as with JsonMap.
+        LazyRef operator[](std::string_view key) const;
+
+        // The value as a regular tree, parsing everything still unread in it.
+        Object *Get() const;
+    };
+
+    // JSON document parsed on demand, for readers that only need a few
+    // fields of a large input. Building it checks that the top-level value
+    // is closed; the rest is validated as it is reached, so errors in a
+    // subtree that is never accessed go unnoticed. Keys point into the
+    // source, which must outlive the document. Not thread-safe, even for
+    // reading, since access parses.
+    class LazyDocument
+    {
+    private:
+        std::unique_ptr<Arena> arena;
+        Object **root; // allocated in the arena, so refs survive moves
+
+    public:
+        explicit LazyDocument(std::string_view jsonString);
+
+        inline LazyRef Root() { return LazyRef(arena.get(), root); }
+        inline Arena &GetArena() { return *arena; }
+    };
+} // namespace Json
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file. The file is mmap'ed when possible so large
+// inputs can be parsed without first being copied into a std::string; when
+// mapping is not possible (pipes, special files) it is read into a buffer.
+class MappedFile
+{
+private:
+    const char *data;
+    size_t size;
+    bool mapped;
+    std::string buffer;
+
+    void Unmap();
+
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    inline std::string_view View() const { return std::string_view(data, size); }
+    inline bool IsMapped() const { return mapped; }
+};
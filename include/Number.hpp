@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include "NumberFormat.hpp"
+#include "Writer.hpp"
+
+// Validates the number grammar accepted by both tokenizers:
+// -?digits(.digits)?([eE][+-]?digits)?
+bool IsNumberLexeme(std::string_view text);
+
+// Hand-written conversions used instead of stod. ParseInteger fails on
+// fractions, exponents and overflow; ParseDouble is exact for the common case
+// of at most 19 significant digits and a small exponent and falls back to
+// std::from_chars otherwise. Out-of-range values become +-HUGE_VAL or +-0,
+// as with strtod.
+bool ParseInteger(std::string_view text, int64_t &value);
+bool ParseInteger(std::string_view text, uint64_t &value);
+bool ParseDouble(std::string_view text, double &value);
+
+// Numeric payload of Json::JsonNumber and Xml::XmlNumber. Integers that fit
+// 64 bits are kept exactly; anything else, including "-0", keeps its source
+// text and is only converted to double the first time it is read.
+class Number
+{
+public:
+    enum class KIND
+    {
+        INT64,
+        UINT64,
+        DOUBLE,
+        LEXEME
+    };
+
+private:
+    KIND kind;
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        double d;
+    };
+    bool converted;
+    std::pmr::string lexeme;
+
+public:
+    explicit Number(double value,
+                    std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : kind(KIND::DOUBLE), d(value), converted(true), lexeme(resource) {}
+    explicit Number(int64_t value,
+                    std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : kind(KIND::INT64), i(value), converted(true), lexeme(resource) {}
+    explicit Number(uint64_t value,
+                    std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : kind(KIND::UINT64), u(value), converted(true), lexeme(resource) {}
+
+    // Builds a number from a token that already passed IsNumberLexeme.
+    static Number FromLexeme(std::string_view text,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    inline KIND getKind() const { return kind; }
+    inline bool IsInteger() const { return kind == KIND::INT64 || kind == KIND::UINT64; }
+    inline std::string_view Lexeme() const { return lexeme; }
+
+    double AsDouble();
+    int64_t AsInt64();
+    uint64_t AsUInt64();
+
+    // Integers are printed exactly and lexemes verbatim, so parsed numbers
+    // round-trip byte for byte.
+    void Write(Writer &out) const;
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Writer.hpp"
+
+// Locale-independent number to text conversion shared by the JSON and XML
+// writers. Doubles are printed with the shortest representation that parses
+// back to the same value; integral values take a cheaper integer path.
+// Non-finite values have no JSON spelling and are written as null.
+
+// Enough room for any value produced by the functions below.
+constexpr size_t kMaxNumberChars = 32;
+
+size_t FormatDouble(double value, char *out);
+size_t FormatInteger(int64_t value, char *out);
+size_t FormatInteger(uint64_t value, char *out);
+
+inline void WriteNumber(Writer &out, double value)
+{
+    char buffer[kMaxNumberChars];
+    out.Write(std::string_view(buffer, FormatDouble(value, buffer)));
+}
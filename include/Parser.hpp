@@ -1,44 +1,120 @@
 #pragma once
+#include <memory>
 #include <string>
 #include "Tokenizer.hpp"
 #include "Json.hpp"
 #include "Xml.hpp"
+#include "Arena.hpp"
+#include "Document.hpp"
+#include "Writer.hpp"
+#include "Sax.hpp"
+#include "Tape.hpp"
+#include "Lazy.hpp"
+#include "SymbolTable.hpp"
+#include "TreeBuilder.hpp"
+#include "Stats.hpp"
 
 class Parser
 {
 private:
-    unsigned int current;
-    std::vector<TokenJson> JsonTokens;
-    std::vector<TokenXml> XmlTokens;
+    JsonLexer *lexer;
+    TokenJson JsonToken;
+    Arena *arena;
+    SymbolTable *symbols; // shared across parses, set by the caller
+    SymbolTable *keys;    // table used by the parse in progress
+
+    // Scratch state kept warm between parses so that, once grown, repeated
+    // parses allocate nothing outside the target arena.
+    SymbolTable scratchSymbols;
+    Xml::TreeBuilder xmlBuilder;
+    Xml::Reader xmlReader;
 
 private:
     Json::Object *ParseJsonValue();
     Json::Object *ParseJsonObject();
     Json::Object *ParseJsonArray();
 
-    Xml::Object *ParseXmlValue();
-    Xml::Object *ParseXmlObject();
-    Xml::Object *ParseXmlArray();
+    Json::Object *ParseJsonInput(std::string_view jsonString);
+    SymbolTable *SelectSymbols();
+    void ReadXml(std::string_view XmlString, Xml::Reader &reader);
+    Xml::Object *ParseXmlInput(std::string_view XmlString);
 
 public:
     Parser()
-    {
-        std::vector<TokenJson> JsonTokens = std::vector<TokenJson>();
-        std::vector<TokenXml> XmlTokens = std::vector<TokenXml>();
-    }
-    Json::Object *ParseJson(std::string &jsonString);
+        : lexer(nullptr), arena(nullptr), symbols(nullptr), keys(nullptr),
+          xmlBuilder(nullptr), xmlReader(xmlBuilder) {}
+
+    Parser(const Parser &) = delete;
+    Parser &operator=(const Parser &) = delete;
+
+    // Forgets the state of the last parse and the symbol table, keeping the
+    // scratch buffers' capacity.
+    void Reset();
+
+    // Keys and element names of the following parses are interned in
+    // `symbols`, which must outlive the resulting documents. Without one,
+    // names are interned per document when parsing into an arena and copied
+    // otherwise.
+    inline void SetSymbolTable(SymbolTable *symbols) { this->symbols = symbols; }
+    // Without an arena the tree is allocated on the heap and owned by its
+    // root; the caller frees it with `delete`.
+    Json::Object *ParseJson(std::string_view jsonString);
+    Json::Object *ParseJson(std::string_view jsonString, Arena &arena);
+    Json::Document ParseJsonDocument(std::string_view jsonString);
+    // Parses into `document` after resetting it, reusing its arena's memory.
+    void ParseJsonDocument(std::string_view jsonString, Json::Document &document);
+    // Parses straight from a read-only mapping of the file.
+    Json::Document ParseJsonFile(const std::string &path);
+    // Reports the document to the handler as events instead of building a tree.
+    void ParseJson(std::string_view jsonString, Json::Handler &handler);
+    // Builds the flat, read-only representation instead of Object nodes.
+    Json::Tape ParseJsonTape(std::string_view jsonString);
+    // Parses objects and arrays only when they are first accessed; unread
+    // subtrees cost a bracket-matching skip. `jsonString` must outlive it.
+    Json::LazyDocument ParseJsonLazy(std::string_view jsonString);
     std::string UnParseJson(Json::Object &object);
+    void UnParseJson(Json::Object &object, Writer &out);
 
-    Xml::Object *ParseXml(std::string &XmlString);
+    // A heap tree as with ParseJson, freed with `delete`.
+    Xml::Object *ParseXml(std::string_view XmlString);
+    Xml::Object *ParseXml(std::string_view XmlString, Arena &arena);
+    Xml::Document ParseXmlDocument(std::string_view XmlString);
+    void ParseXmlDocument(std::string_view XmlString, Xml::Document &document);
+    Xml::Document ParseXmlFile(const std::string &path);
+    void ParseXml(std::string_view XmlString, Xml::Handler &handler);
     std::string UnParseXml(Xml::Object &object);
+    void UnParseXml(Xml::Object &object, Writer &out);
 
-    std::string JsonToXml(std::string& jsonString);
-    std::string XmlToJson(std::string& XmlString);
+    std::string JsonToXml(std::string_view jsonString);
+    std::string XmlToJson(std::string_view XmlString);
+    void JsonToXml(std::string_view jsonString, Writer &out);
+    void XmlToJson(std::string_view XmlString, Writer &out);
 
 private:
-    inline TokenJson currentTokenJson() { return this->JsonTokens[current]; };
-    inline TokenJson nextTokenJson() { return this->JsonTokens[++current]; };
+    // Nodes come from the arena of the document being built, or from the heap
+    // when the caller did not supply one.
+    template <typename T, typename... Args>
+    inline T *Make(Args &&...args)
+    {
+        Stats::CountNode();
+        if (this->arena != nullptr)
+            return this->arena->Create<T>(std::forward<Args>(args)...);
+        return new T(std::forward<Args>(args)...);
+    }
+    // The node itself when it came from the heap, so that a failed parse or a
+    // replaced duplicate key can free it; null for arena nodes.
+    inline Json::Object *HeapOwner(Json::Object *node) const
+    {
+        return this->arena == nullptr ? node : nullptr;
+    }
 
-    inline TokenXml currentTokenXml() { return this->XmlTokens[current]; };
-    inline TokenXml nextTokenXml() { return  this->XmlTokens[++current]; };
+    // JSON is parsed in a single pass: tokens are pulled from the lexer on
+    // demand, so only the current token is alive at any time.
+    inline const TokenJson &currentTokenJson() { return this->JsonToken; };
+    inline const TokenJson &nextTokenJson()
+    {
+        if (!this->lexer->NextToken(this->JsonToken))
+            throw std::runtime_error("Unexpected end of input");
+        return this->JsonToken;
+    };
 };
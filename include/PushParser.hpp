@@ -0,0 +1,75 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "Sax.hpp"
+#include "TreeBuilder.hpp"
+#include "Document.hpp"
+
+// Resumable readers for documents that arrive in pieces (socket reads, pipe
+// chunks). Each feed() tokenizes as much of the chunk as possible with the
+// regular lexer rules and reports events to the handler; only a token cut
+// off at the end of a chunk is carried over, so the raw text is never held
+// in full. finish() flushes that last token and checks the document is
+// complete.
+class JsonPushReader
+{
+private:
+    Json::Reader reader;
+    std::string pending;
+
+    size_t Drain(std::string_view input, bool final);
+
+public:
+    JsonPushReader(Json::Handler &handler) : reader(handler) {}
+
+    void feed(std::string_view chunk);
+    void finish();
+};
+
+class XmlPushReader
+{
+private:
+    Xml::Reader reader;
+    std::string pending;
+
+    size_t Drain(std::string_view input, bool final);
+
+public:
+    XmlPushReader(Xml::Handler &handler) : reader(handler) {}
+
+    void feed(std::string_view chunk);
+    void finish();
+};
+
+// Push readers that build the regular tree into a document.
+class JsonPushParser
+{
+private:
+    Json::Document document;
+    SymbolTable symbols;
+    Json::TreeBuilder builder;
+    JsonPushReader reader;
+
+public:
+    JsonPushParser()
+        : symbols(document.GetArena()), builder(&document.GetArena(), &symbols), reader(builder) {}
+
+    inline void feed(std::string_view chunk) { reader.feed(chunk); }
+    Json::Document finish();
+};
+
+class XmlPushParser
+{
+private:
+    Xml::Document document;
+    SymbolTable symbols;
+    Xml::TreeBuilder builder;
+    XmlPushReader reader;
+
+public:
+    XmlPushParser()
+        : symbols(document.GetArena()), builder(&document.GetArena(), &symbols), reader(builder) {}
+
+    inline void feed(std::string_view chunk) { reader.feed(chunk); }
+    Xml::Document finish();
+};
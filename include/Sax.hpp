@@ -0,0 +1,107 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Tokenizer.hpp"
+
+// Event-driven interface to both formats. A reader validates the token
+// stream coming out of the lexer and reports it to a Handler without
+// building a tree, so consumers can filter, aggregate or transcode in
+// constant memory. All views passed to a handler are only valid for the
+// duration of the callback. Strings are reported raw (JSON escapes kept) and
+// numbers as their source lexeme.
+namespace Json
+{
+    class Handler
+    {
+    public:
+        virtual ~Handler() = default;
+
+        virtual void onStartObject() {}
+        virtual void onEndObject() {}
+        virtual void onStartArray() {}
+        virtual void onEndArray() {}
+        virtual void onKey(std::string_view key) {}
+        virtual void onString(std::string_view value) {}
+        virtual void onNumber(std::string_view lexeme) {}
+        virtual void onBoolean(bool value) {}
+        virtual void onNull() {}
+    };
+
+    // Turns JSON tokens into Handler events, enforcing object/array syntax.
+    class Reader
+    {
+    private:
+        enum class STATE
+        {
+            VALUE,
+            VALUE_OR_END,
+            KEY,
+            KEY_OR_END,
+            COLON,
+            COMMA_OR_END,
+            DONE
+        };
+
+        Handler &handler;
+        std::vector<bool> stack; // true for objects
+        STATE state;
+
+        void Close(TOKEN_TYPE type);
+        inline void ValueDone() { state = stack.empty() ? STATE::DONE : STATE::COMMA_OR_END; }
+
+    public:
+        Reader(Handler &handler) : handler(handler), state(STATE::VALUE) {}
+
+        void OnToken(const TokenJson &token);
+        inline bool Done() const { return state == STATE::DONE; }
+        inline size_t Depth() const { return stack.size(); }
+        inline void Reset()
+        {
+            stack.clear();
+            state = STATE::VALUE;
+        }
+    };
+} // namespace Json
+
+namespace Xml
+{
+    class Handler
+    {
+    public:
+        virtual ~Handler() = default;
+
+        // `attributes` is the raw text after the tag name; see
+        // SplitXmlAttributes.
+        virtual void onStartElement(std::string_view name, std::string_view attributes) {}
+        virtual void onEndElement(std::string_view name) {}
+        virtual void onString(std::string_view value) {}
+        virtual void onNumber(std::string_view lexeme) {}
+        virtual void onBoolean(bool value) {}
+        virtual void onNull() {}
+    };
+
+    // Turns XML tokens into Handler events, checking that tags nest properly
+    // and that the document has a single root element.
+    class Reader
+    {
+    private:
+        Handler &handler;
+        std::vector<std::string> stack; // open tags; entries past `depth` keep their capacity
+        size_t depth;
+        bool done;
+
+    public:
+        Reader(Handler &handler) : handler(handler), depth(0), done(false) {}
+
+        void OnToken(const TokenXml &token);
+        inline bool Done() const { return done; }
+        inline size_t Depth() const { return depth; }
+        // Prepares for another document, keeping allocated buffers.
+        inline void Reset()
+        {
+            depth = 0;
+            done = false;
+        }
+    };
+} // namespace Xml
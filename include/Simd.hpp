@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized byte classification for the tokenizers. Input is examined 64
+// bytes at a time and turned into bitmasks (bit i set = byte i matches), so
+// whitespace runs, string bodies and structural characters can be skipped
+// with a count-trailing-zeros instead of a per-character branch chain.
+// The AVX2 or SSE4.2 kernel is picked at runtime; other targets use a scalar
+// loop producing the same masks. The per-token scans used by the lexer look
+// at a few bytes directly and only vectorize long runs.
+namespace Simd
+{
+    constexpr size_t kBlockSize = 64;
+
+    struct BlockMasks
+    {
+        uint64_t quote;      // "
+        uint64_t backslash;  // \.
+        uint64_t structural; // { } [ ] : ,
+        uint64_t whitespace; // space, \t, \n, \r
+    };
+
+    // Classifies data[0, size) with size <= kBlockSize; bits past size are 0.
+    void Classify(const char *data, size_t size, BlockMasks &masks);
+
+    // Bytes examined one at a time before a scan switches to vector
+    // compares: the gaps between tokens and most strings are shorter, and
+    // starting a vector scan for them costs more than it saves.
+    constexpr size_t kScalarRun = 16;
+
+    inline bool IsWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // Vector scans for runs longer than kScalarRun.
+    size_t FindQuoteOrBackslashLong(const char *data, size_t pos, size_t size);
+    size_t SkipWhitespaceLong(const char *data, size_t pos, size_t size);
+
+    // Index of the first '"' or '\\' at or after pos, or size if none.
+    inline size_t FindQuoteOrBackslash(const char *data, size_t pos, size_t size)
+    {
+        if (pos >= size)
+            return size;
+        size_t end = size - pos > kScalarRun ? pos + kScalarRun : size;
+        for (; pos < end; pos++)
+        {
+            if (data[pos] == '"' || data[pos] == '\\')
+                return pos;
+        }
+        return pos < size ? FindQuoteOrBackslashLong(data, pos, size) : size;
+    }
+
+    // Index of the first non-whitespace byte at or after pos, or size.
+    inline size_t SkipWhitespace(const char *data, size_t pos, size_t size)
+    {
+        if (pos >= size)
+            return size;
+        size_t end = size - pos > kScalarRun ? pos + kScalarRun : size;
+        for (; pos < end; pos++)
+        {
+            if (!IsWhitespace(data[pos]))
+                return pos;
+        }
+        return pos < size ? SkipWhitespaceLong(data, pos, size) : size;
+    }
+
+    // Index of the bracket closing the '{' or '[' at data[open], found by
+    // counting structural brackets outside strings, or size if it is never
+    // closed. Bracket kinds are not checked against each other.
+    size_t MatchClose(const char *data, size_t open, size_t size);
+
+    // Follows JSON string state across consecutive blocks. Next() takes the
+    // masks of the following block and returns the bytes that lie inside a
+    // string, opening quote included, with escaped quotes accounted for.
+    class StringScanner
+    {
+    private:
+        uint64_t nextEscaped; // 1 if the block starts with an escaped byte
+        uint64_t inString;    // all ones if the block starts inside a string
+
+    public:
+        StringScanner() : nextEscaped(0), inString(0) {}
+
+        uint64_t Next(const BlockMasks &masks);
+        inline bool InString() const { return inString != 0; }
+    };
+
+    // Name of the kernel selected for this CPU ("avx2", "sse4.2", "scalar").
+    const char *KernelName();
+    // Switches every scan to the named kernel, so tests can check them all
+    // against each other; false if this CPU cannot run it. Not safe while
+    // other threads are scanning.
+    bool UseKernel(const char *name);
+} // namespace Simd
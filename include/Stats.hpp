@@ -0,0 +1,225 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Optional instrumentation of parsing and serialization, compiled in when
+// JSONXML_STATS is defined (cmake -DJSONXML_STATS=ON). Without it every hook
+// below is an empty inline function and costs nothing.
+//
+// Counters are kept per thread. Each top-level call (a parse, a
+// toJsonString, a push parser's feed, ...) is one operation; calls it makes
+// into other entry points are part of it. When an operation ends, including
+// by an exception, its counters are added to the thread's totals and passed
+// to the callback.
+namespace Stats
+{
+#if defined(JSONXML_STATS)
+    constexpr bool kEnabled = true;
+#else
+    constexpr bool kEnabled = false;
+#endif
+
+    enum class PHASE
+    {
+        PARSE,    // whole parses, tokenizing included
+        TOKENIZE, // inside the lexers, sampled (see TokenScope)
+        SERIALIZE
+    };
+    constexpr size_t kPhases = 3;
+    constexpr size_t kTokenTypes = 13; // one per TOKEN_TYPE
+    constexpr uint64_t kTokenSample = 64; // one token in this many is timed
+
+    struct Counters
+    {
+        uint64_t nanoseconds[kPhases] = {}; // wall time, indexed by PHASE
+        uint64_t bytesParsed = 0;
+        uint64_t bytesEmitted = 0;
+        uint64_t tokens[kTokenTypes] = {}; // indexed by TOKEN_TYPE
+        uint64_t nodes = 0;                // tree nodes created
+        uint64_t maxDepth = 0;             // of objects, arrays and elements
+
+        inline uint64_t Nanoseconds(PHASE phase) const { return nanoseconds[static_cast<size_t>(phase)]; }
+        // Parse time not spent in the lexers. Tokenizing is an estimate, so
+        // this is clamped at zero.
+        inline uint64_t BuildNanoseconds() const
+        {
+            uint64_t parse = Nanoseconds(PHASE::PARSE), tokenize = Nanoseconds(PHASE::TOKENIZE);
+            return parse > tokenize ? parse - tokenize : 0;
+        }
+        uint64_t Tokens() const;
+        void Add(const Counters &other);
+    };
+
+    // Called on the thread that ran the operation, so it must be thread-safe
+    // when several threads parse; it must not throw. Set it before any work
+    // starts, the hook itself is not synchronized.
+    using Callback = std::function<void(const Counters &)>;
+    void SetCallback(Callback callback);
+
+    // Sum of the calling thread's operations since the last ResetTotals().
+    const Counters &Totals();
+    void ResetTotals();
+
+    namespace Detail
+    {
+        struct State
+        {
+            Counters current; // operation in progress
+            Counters totals;
+            unsigned operations = 0;      // nesting of Operation
+            unsigned timers[kPhases] = {}; // nesting of Timer, per phase
+            uint64_t tokenCalls = 0;       // drives TokenScope's sampling
+            uint64_t depth = 0;
+        };
+
+        State &Local();
+        uint64_t Now();
+        // Cost of a Now() pair, taken off each sampled token.
+        uint64_t ClockOverhead();
+        void BeginOperation();
+        void EndOperation();
+    } // namespace Detail
+
+    inline void CountBytesParsed(size_t bytes)
+    {
+        if constexpr (kEnabled)
+            Detail::Local().current.bytesParsed += bytes;
+    }
+    inline void CountBytesEmitted(size_t bytes)
+    {
+        if constexpr (kEnabled)
+            Detail::Local().current.bytesEmitted += bytes;
+    }
+    inline void CountNode()
+    {
+        if constexpr (kEnabled)
+            Detail::Local().current.nodes++;
+    }
+    // Nesting depth reached by a reader that tracks its own.
+    inline void Depth(size_t depth)
+    {
+        if constexpr (kEnabled)
+        {
+            Counters &current = Detail::Local().current;
+            if (depth > current.maxDepth)
+                current.maxDepth = depth;
+        }
+    }
+    // Depth tracking for recursive descent.
+    inline void Enter()
+    {
+        if constexpr (kEnabled)
+            Depth(++Detail::Local().depth);
+    }
+    inline void Leave()
+    {
+        if constexpr (kEnabled)
+            Detail::Local().depth--;
+    }
+
+    // Adds the time until its destruction to `phase`, unless an enclosing
+    // timer of the same phase already counts it.
+    class Timer
+    {
+    private:
+        size_t phase;
+        uint64_t start;
+
+    public:
+        explicit Timer(PHASE phase)
+        {
+            if constexpr (kEnabled)
+            {
+                this->phase = static_cast<size_t>(phase);
+                this->start = Detail::Local().timers[this->phase]++ == 0 ? Detail::Now() : 0;
+            }
+        }
+        ~Timer()
+        {
+            if constexpr (kEnabled)
+            {
+                Detail::State &state = Detail::Local();
+                if (--state.timers[phase] == 0)
+                    state.current.nanoseconds[phase] += Detail::Now() - start;
+            }
+        }
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+    };
+
+    // Per-token hook of the lexers. Reading the clock around every token
+    // would cost more than lexing it, so only one call in kTokenSample is
+    // timed, less the clock's own cost, and scaled up; the others just
+    // count. Nothing is added inside a Timer of the TOKENIZE phase, which
+    // times the whole run.
+    class TokenScope
+    {
+    private:
+        Detail::State *state;
+        uint64_t start;
+
+    public:
+        TokenScope()
+        {
+            if constexpr (kEnabled)
+            {
+                state = &Detail::Local();
+                bool sample = ++state->tokenCalls % kTokenSample == 0 &&
+                              state->timers[static_cast<size_t>(PHASE::TOKENIZE)] == 0;
+                start = sample ? Detail::Now() : 0;
+            }
+        }
+        ~TokenScope()
+        {
+            if constexpr (kEnabled)
+            {
+                if (start != 0)
+                {
+                    uint64_t elapsed = Detail::Now() - start;
+                    uint64_t overhead = Detail::ClockOverhead();
+                    if (elapsed > overhead)
+                        state->current.nanoseconds[static_cast<size_t>(PHASE::TOKENIZE)] += (elapsed - overhead) * kTokenSample;
+                }
+            }
+        }
+        inline void Count(size_t type)
+        {
+            if constexpr (kEnabled)
+                state->current.tokens[type]++;
+        }
+
+        TokenScope(const TokenScope &) = delete;
+        TokenScope &operator=(const TokenScope &) = delete;
+    };
+
+    // Scope of an entry point, timed under `phase`. The timer is declared
+    // after the boundary, so it stops before the operation is reported.
+    class Operation
+    {
+    private:
+        struct Boundary
+        {
+            Boundary()
+            {
+                if constexpr (kEnabled)
+                    Detail::BeginOperation();
+            }
+            ~Boundary()
+            {
+                if constexpr (kEnabled)
+                    Detail::EndOperation();
+            }
+        };
+
+        Boundary boundary;
+        Timer timer;
+
+    public:
+        explicit Operation(PHASE phase) : timer(phase) {}
+
+        Operation(const Operation &) = delete;
+        Operation &operator=(const Operation &) = delete;
+    };
+} // namespace Stats
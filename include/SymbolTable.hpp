@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "Arena.hpp"
+
+// Interns map keys and element names so that every occurrence of a name
+// refers to one canonical copy. Symbols from the same table are equal exactly
+// when their data pointers are equal.
+//
+// A table either owns its storage, and can then be shared by several parses
+// (symbols stay valid until the table is destroyed or cleared), or writes
+// into a caller's arena, typically the one of the document being built. The
+// lookup table is open-addressed and keeps its capacity when cleared, so a
+// reused table does not allocate. Not thread-safe.
+class SymbolTable
+{
+private:
+    std::unique_ptr<Arena> owned;
+    Arena *storage;
+    std::vector<std::string_view> slots; // null data when free
+    size_t count;
+
+    void Grow();
+
+public:
+    SymbolTable();
+    explicit SymbolTable(Arena &storage);
+
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    std::string_view Intern(std::string_view text);
+
+    inline size_t Size() const { return count; }
+    // Forgets every symbol; frees them too when the table owns its storage.
+    void Clear();
+    // Forgets every symbol and writes new ones into `storage`.
+    void Reset(Arena &storage);
+};
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Sax.hpp"
+#include "Writer.hpp"
+#include "Json.hpp"
+
+namespace Json
+{
+    class TapeRef;
+
+    // Read-only document stored as one contiguous array of 64-bit entries,
+    // an alternative to the Object tree with no per-node allocation. The top
+    // byte of an entry is its tag, the low 56 bits its payload:
+    //
+    //   '{' '['      index of the matching end entry
+    //   '}'          number of members
+    //   ']'          offset in `items` of the item count, followed by the
+    //                entry index of each item
+    //   'k' '"' 'n'  offset of a key, string or number lexeme in `strings`
+    //   'l' 'u'      index of an int64 / uint64 value in `numbers`
+    //   't' 'f' '0'  true, false, null (no payload)
+    //
+    // Object members are a key entry followed by the value. Strings keep
+    // their JSON escapes, like JsonString; non-integral numbers keep their
+    // lexeme and are converted on access, like Number.
+    class Tape
+    {
+    private:
+        friend class TapeRef;
+        friend class TapeBuilder;
+
+        std::vector<uint64_t> entries;
+        std::string strings; // 32-bit length followed by the bytes
+        std::vector<uint64_t> numbers;
+        std::vector<uint64_t> items; // per array, so indexing is O(1)
+
+        static constexpr int kTagShift = 56;
+        static constexpr uint64_t kPayloadMask = (uint64_t(1) << kTagShift) - 1;
+
+        inline char Tag(size_t index) const { return static_cast<char>(entries[index] >> kTagShift); }
+        inline uint64_t Payload(size_t index) const { return entries[index] & kPayloadMask; }
+        inline void Append(char tag, uint64_t payload = 0)
+        {
+            entries.push_back((uint64_t(static_cast<unsigned char>(tag)) << kTagShift) | payload);
+        }
+        uint64_t AppendString(std::string_view text);
+        std::string_view String(size_t index) const;
+        // Index just past the value starting at `index`.
+        inline size_t Skip(size_t index) const
+        {
+            char tag = Tag(index);
+            return (tag == '{' || tag == '[') ? Payload(index) + 1 : index + 1;
+        }
+
+        void WriteJson(Writer &out, size_t index) const;
+
+    public:
+        TapeRef Root() const;
+        inline bool Empty() const { return entries.empty(); }
+        inline size_t Entries() const { return entries.size(); }
+        void Clear();
+
+        void writeJson(Writer &out) const;
+        std::string toJsonString() const;
+    };
+
+    // Cursor to one value of a Tape; cheap to copy. Looking up a missing key
+    // or index gives an invalid ref, which evaluates to false; indexing or
+    // iterating it again gives another invalid ref, while its value
+    // accessors throw.
+    class TapeRef
+    {
+    private:
+        const Tape *tape;
+        size_t index;
+
+    public:
+        TapeRef() : tape(nullptr), index(0) {}
+        TapeRef(const Tape *tape, size_t index) : tape(tape), index(index) {}
+
+        inline explicit operator bool() const { return tape != nullptr; }
+        OBJECT_TYPE getType() const;
+
+        // Members and items, in document order.
+        size_t Size() const;
+        TapeRef operator[](size_t index) const;
+        // Last member with that key, as with JsonMap.
+        TapeRef operator[](std::string_view key) const;
+
+        // First item or member value of a container, and the value after this
+        // one in its parent; both are invalid past the end. Key() is the key
+        // of a member reached this way.
+        TapeRef Begin() const;
+        TapeRef Next() const;
+        std::string_view Key() const;
+
+        bool AsBool() const;
+        std::string_view AsString() const;
+        double AsDouble() const;
+        int64_t AsInt64() const;
+        uint64_t AsUInt64() const;
+        // Whether the number is held as an exact 64-bit integer.
+        bool IsInteger() const;
+    };
+
+    // Handler that appends reader events to a tape.
+    class TapeBuilder : public Handler
+    {
+    private:
+        Tape &tape;
+        std::vector<size_t> starts;
+        std::vector<uint64_t> counts;
+        std::vector<uint64_t> pending; // item entries of the open arrays
+        bool inArray = false;
+
+        inline void Value()
+        {
+            if (inArray)
+                pending.push_back(tape.entries.size());
+            if (!counts.empty())
+                counts.back()++;
+        }
+        void Start(char tag);
+        void End(char tag);
+
+    public:
+        TapeBuilder(Tape &tape) : tape(tape) {}
+
+        void onStartObject() override { Start('{'); }
+        void onEndObject() override { End('}'); }
+        void onStartArray() override { Start('['); }
+        void onEndArray() override { End(']'); }
+        void onKey(std::string_view key) override { tape.Append('k', tape.AppendString(key)); }
+        void onString(std::string_view value) override;
+        void onNumber(std::string_view lexeme) override;
+        void onBoolean(bool value) override;
+        void onNull() override;
+    };
+} // namespace Json
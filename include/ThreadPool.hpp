@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with one task queue each. Tasks submitted from
+// a worker go to its own queue, others are dealt round-robin; a worker pops
+// from the back of its queue and, when it runs dry, steals from the front of
+// the others, so uneven tasks still keep every core busy. Tasks must not
+// throw, and Wait() must not be called from inside a task.
+class ThreadPool
+{
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    size_t queued;  // submitted but not yet taken, guarded by `mutex`
+    size_t pending; // submitted but not yet finished, guarded by `mutex`
+    bool stopping;
+    std::atomic<size_t> next;
+
+    static thread_local ThreadPool *currentPool;
+    static thread_local size_t currentIndex;
+
+    bool TryTake(size_t self, std::function<void()> &task);
+    void Run(size_t self);
+
+public:
+    // Zero means one thread per hardware thread.
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void Submit(std::function<void()> task);
+    // Blocks until every submitted task has finished.
+    void Wait();
+
+    inline size_t Size() const { return workers.size(); }
+};
@@ -1,7 +1,10 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include "Json.hpp"
+#include "Stats.hpp"
 
 enum class TOKEN_TYPE
 {
@@ -20,17 +23,27 @@ enum class TOKEN_TYPE
     TAG_CLOSE,
 };
 
+// Splits raw attribute text (`id="1" lang="en"`) into name/value pairs.
+std::vector<std::pair<std::string_view, std::string_view>> SplitXmlAttributes(std::string_view attributes);
+
+// ASCII case-insensitive comparison against an already lower-case word, and
+// the literals XML text is recognized by: true, false and null in any case.
+bool equalsIgnoreCase(std::string_view str, std::string_view lower);
+bool isBooleanTrue(std::string_view str);
+bool isBooleanFalse(std::string_view str);
+bool isNull(std::string_view str);
+
+// Tokens do not own their text: `value` points into the input buffer, which
+// must outlive them. String values are left exactly as written (escape
+// sequences included); use UnescapeJson when the decoded text is needed.
 typedef struct TokenJson
 {
     TOKEN_TYPE type;
-    std::string value;
+    std::string_view value;
 
-    TokenJson(TOKEN_TYPE type, std::string value)
-    {
-        this->type = type;
-        this->value = value;
-    }
-    TokenJson(TOKEN_TYPE type, char value)
+    TokenJson() : type(TOKEN_TYPE::NONE) {}
+
+    TokenJson(TOKEN_TYPE type, std::string_view value)
     {
         this->type = type;
         this->value = value;
@@ -40,32 +53,95 @@ typedef struct TokenJson
 typedef struct TokenXml
 {
     TOKEN_TYPE type;
-    std::string value;
-    std::map<std::string , std::string> attributes;
+    std::string_view value;
+    // Raw text between the tag name and '>', split by Attributes() on demand.
+    std::string_view attributes;
 
-    inline void addAttribute(std::string first, std::string second){
-        attributes[first] = second;
-    }
+    std::vector<std::pair<std::string_view, std::string_view>> Attributes() const;
 
-    TokenXml(TOKEN_TYPE type, std::string value)
-    {
-        this->type = type;
-        this->value = value;
-    }
-    TokenXml(TOKEN_TYPE type, char value)
+    TokenXml() : type(TOKEN_TYPE::NONE) {}
+
+    TokenXml(TOKEN_TYPE type, std::string_view value)
     {
         this->type = type;
         this->value = value;
     }
 
-    bool isEqual(TokenXml token){
+    bool isEqual(const TokenXml &token) const {
         return token.type == this->type && token.value == this->value;
     }
 } TokenXml;
 
+// Pulls JSON tokens one at a time from the input instead of materializing
+// the whole token vector, so callers only ever hold the current token.
+// A non-final lexer is fed a prefix of a larger stream: a token cut off by
+// the end of the input is not an error but makes NextToken return false
+// with Incomplete() set, leaving Position() at the start of that token.
+class JsonLexer
+{
+private:
+    std::string_view input;
+    size_t current;
+    bool final;
+    bool incomplete;
+
+    bool Lex(TokenJson &token);
+
+public:
+    JsonLexer(std::string_view jsonString, bool final = true)
+        : input(jsonString), current(0), final(final), incomplete(false) {}
+
+    // Reads the next token into `token`; returns false at end of input.
+    inline bool NextToken(TokenJson &token)
+    {
+        Stats::TokenScope scope;
+        bool found = Lex(token);
+        if (found)
+            scope.Count(static_cast<size_t>(token.type));
+        return found;
+    }
+
+    inline size_t Position() const { return current; }
+    inline bool Incomplete() const { return incomplete; }
+    // Continues lexing at `position`, e.g. past a skipped subtree.
+    inline void Seek(size_t position) { current = position; }
+};
+
+// XML counterpart of JsonLexer. Whitespace-only text between tags, comments,
+// processing instructions and <!DOCTYPE> are skipped; a self-closing tag
+// yields a TAG_OPEN followed by a TAG_CLOSE; text is trimmed.
+class XmlLexer
+{
+private:
+    std::string_view input;
+    size_t current;
+    bool final;
+    bool incomplete;
+    std::string_view pendingClose;
+
+    bool Cut(size_t start);
+    bool Lex(TokenXml &token);
+
+public:
+    XmlLexer(std::string_view XmlString, bool final = true)
+        : input(XmlString), current(0), final(final), incomplete(false) {}
+
+    inline bool NextToken(TokenXml &token)
+    {
+        Stats::TokenScope scope;
+        bool found = Lex(token);
+        if (found)
+            scope.Count(static_cast<size_t>(token.type));
+        return found;
+    }
+
+    inline size_t Position() const { return current; }
+    inline bool Incomplete() const { return incomplete; }
+};
+
 class Tokenizer
 {
 public:
-    std::vector<TokenJson> TokenizeJson(std::string &jsonString);
-    std::vector<TokenXml> TokenizeXml(std::string &XmlString);
+    std::vector<TokenJson> TokenizeJson(std::string_view jsonString);
+    std::vector<TokenXml> TokenizeXml(std::string_view XmlString);
 };
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Sax.hpp"
+#include "Writer.hpp"
+
+// Handlers that translate reader events of one format straight into the
+// other, producing the same output as converting through the object trees
+// but without building them.
+namespace Json
+{
+    // Object members become elements named after their key, in document
+    // order; array items are written as repeated elements named after the
+    // key holding the array. Nothing is buffered, memory only grows with
+    // nesting depth.
+    class XmlTranscoder : public Handler
+    {
+    private:
+        struct Frame
+        {
+            bool isMap;
+            bool element; // whether the container opened an element of its own
+            std::string tag;
+            std::string name; // element name for the next member or item
+        };
+
+        Writer &out;
+        std::vector<Frame> stack;
+        std::vector<bool> written; // per element level: a child was written
+
+        void Open(std::string_view name);
+        void Close(std::string_view name);
+        void StartContainer(bool isMap);
+        void EndContainer();
+
+    public:
+        XmlTranscoder(Writer &out) : out(out), written{false} {}
+
+        void onStartObject() override { StartContainer(true); }
+        void onEndObject() override { EndContainer(); }
+        void onStartArray() override { StartContainer(false); }
+        void onEndArray() override { EndContainer(); }
+        void onKey(std::string_view key) override { stack.back().name.assign(key); }
+        void onString(std::string_view value) override;
+        void onNumber(std::string_view lexeme) override;
+        void onBoolean(bool value) override;
+        void onNull() override;
+    };
+} // namespace Json
+
+namespace Xml
+{
+    // Thrown by JsonTranscoder for a repeated element name with other names
+    // between the repeats. Grouping those into one array needs the whole
+    // parent, which Parser::XmlToJson then converts through the tree.
+    class NonAdjacentRepeat : public std::runtime_error
+    {
+    public:
+        explicit NonAdjacentRepeat(std::string_view name)
+            : std::runtime_error("Repeated element is not adjacent to its previous occurrence: " + std::string(name)) {}
+    };
+
+    // Elements are written as they close, straight to the output. Only a
+    // run of same-name siblings is pending: whether its first element is a
+    // plain member or starts an array is known once the next sibling opens,
+    // so the output from that element on is held in the Writer until then
+    // and turned into an array in place. Memory is bounded by nesting depth,
+    // the distinct child names of the open elements, and the first element
+    // of the open runs.
+    class JsonTranscoder : public Handler
+    {
+    private:
+        enum class TEXT
+        {
+            NONE,
+            STRING,
+            LITERAL
+        };
+
+        // Names of the runs an element has started, to spot repeats that
+        // are not adjacent. Linear up to kLinearNames, then hashed.
+        struct NameSet
+        {
+            std::vector<std::string> names;
+            size_t used = 0;
+            std::vector<size_t> index; // open addressing, name + 1
+
+            bool Insert(std::string_view name);
+            void Clear() { used = 0; }
+
+        private:
+            void Index(size_t name);
+        };
+
+        struct Frame
+        {
+            TEXT kind;
+            std::string text;
+            bool hasChildren;
+            size_t members;
+            std::string runName;
+            size_t runCount;
+            size_t runStart; // output position of the run's first element
+            NameSet runs;
+        };
+
+        static constexpr size_t kLinearNames = 8;
+        static constexpr size_t kNoLevel = ~size_t(0);
+
+        Writer &out;
+        std::vector<Frame> frames; // reused across elements, `depth` are live
+        size_t depth;
+        size_t heldLevel; // outermost frame whose run's first element is held
+        std::string first; // scratch copy of a first element turned into an item
+
+        void StartArray(Frame &frame);
+        void EndRun(size_t level);
+        void SetText(TEXT kind, std::string_view text);
+
+    public:
+        JsonTranscoder(Writer &out) : out(out), depth(0), heldLevel(kNoLevel) {}
+
+        void onStartElement(std::string_view name, std::string_view attributes) override;
+        void onEndElement(std::string_view name) override;
+        void onString(std::string_view value) override { SetText(TEXT::STRING, value); }
+        void onNumber(std::string_view lexeme) override { SetText(TEXT::LITERAL, lexeme); }
+        void onBoolean(bool value) override { SetText(TEXT::LITERAL, value ? "true" : "false"); }
+        void onNull() override { SetText(TEXT::LITERAL, "null"); }
+    };
+} // namespace Xml
@@ -0,0 +1,112 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Arena.hpp"
+#include "SymbolTable.hpp"
+#include "Sax.hpp"
+#include "Stats.hpp"
+#include "Json.hpp"
+#include "Xml.hpp"
+
+// Handlers that assemble the regular object trees from reader events. Nodes
+// come from the given arena, or from the heap when it is null, in which case
+// the caller owns the finished root. Map keys are interned in `symbols` when
+// one is given, and copied otherwise.
+namespace Json
+{
+    class TreeBuilder : public Handler
+    {
+    private:
+        Arena *arena;
+        SymbolTable *symbols;
+        std::vector<Object *> stack;
+        std::string keyCopy;
+        std::string_view key;
+        Object *root;
+
+        void Add(Object *value);
+
+        template <typename T, typename... Args>
+        inline T *Make(Args &&...args)
+        {
+            Stats::CountNode();
+            if (arena != nullptr)
+                return arena->Create<T>(std::forward<Args>(args)...);
+            return new T(std::forward<Args>(args)...);
+        }
+
+    public:
+        TreeBuilder(Arena *arena, SymbolTable *symbols = nullptr)
+            : arena(arena), symbols(symbols), root(nullptr) {}
+
+        void onStartObject() override;
+        void onEndObject() override { stack.pop_back(); }
+        void onStartArray() override;
+        void onEndArray() override { stack.pop_back(); }
+        void onKey(std::string_view key) override;
+        void onString(std::string_view value) override;
+        void onNumber(std::string_view lexeme) override;
+        void onBoolean(bool value) override;
+        void onNull() override;
+
+        inline Object *Root() const { return root; }
+        // Frees a heap tree left unfinished by a failed parse.
+        void Discard();
+    };
+} // namespace Json
+
+namespace Xml
+{
+    // An element becomes a map of its child elements, or its text value when
+    // it has no children. Repeated sibling names are grouped into an array
+    // under that name as they arrive, so no lookahead is needed.
+    class TreeBuilder : public Handler
+    {
+    private:
+        struct Frame
+        {
+            XmlMap *children;
+            Object *text;
+        };
+
+        Arena *arena;
+        SymbolTable *symbols;
+        std::vector<Frame> stack;
+        Object *root;
+
+        void AddChild(Frame &parent, std::string_view name, Object *value);
+
+        template <typename T, typename... Args>
+        inline T *Make(Args &&...args)
+        {
+            Stats::CountNode();
+            if (arena != nullptr)
+                return arena->Create<T>(std::forward<Args>(args)...);
+            return new T(std::forward<Args>(args)...);
+        }
+
+    public:
+        TreeBuilder(Arena *arena, SymbolTable *symbols = nullptr)
+            : arena(arena), symbols(symbols), root(nullptr) {}
+
+        void onStartElement(std::string_view name, std::string_view attributes) override;
+        void onEndElement(std::string_view name) override;
+        void onString(std::string_view value) override;
+        void onNumber(std::string_view lexeme) override;
+        void onBoolean(bool value) override;
+        void onNull() override;
+
+        inline Object *Root() const { return root; }
+        // Frees a heap tree left unfinished by a failed parse.
+        void Discard();
+        // Starts a new tree, keeping the element stack's capacity.
+        inline void Reset(Arena *arena, SymbolTable *symbols)
+        {
+            this->arena = arena;
+            this->symbols = symbols;
+            stack.clear();
+            root = nullptr;
+        }
+    };
+} // namespace Xml
@@ -0,0 +1,98 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Output sink shared by the JSON and XML serializers. Every node appends into
+// the same buffer, so a document is written in one linear pass regardless of
+// its depth. The sink is either a caller-owned std::string, an std::ostream or
+// a file descriptor; the latter two are fed in large chunks.
+class Writer
+{
+private:
+    std::string chunk;
+    std::string *buffer;
+    size_t start;   // size of the caller's string when writing began
+    size_t flushed; // bytes already passed to the stream or descriptor
+    std::ostream *stream;
+    int fd;
+
+    bool pretty;
+    unsigned int indentWidth;
+    unsigned int depth;
+
+    size_t hold;    // output from here on stays buffered, see Hold()
+    size_t flushAt; // chunk size that triggers the next flush
+
+    inline void FlushIfFull()
+    {
+        if (buffer == &chunk && chunk.size() >= flushAt)
+            Flush();
+    }
+
+public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+    static constexpr size_t kNoHold = ~size_t(0);
+
+    explicit Writer(std::string &out, bool pretty = false, unsigned int indentWidth = 2);
+    explicit Writer(std::ostream &out, bool pretty = false, unsigned int indentWidth = 2);
+    explicit Writer(int fd, bool pretty = false, unsigned int indentWidth = 2);
+    ~Writer();
+
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    inline void Write(char c)
+    {
+        buffer->push_back(c);
+        FlushIfFull();
+    }
+    inline void Write(std::string_view text)
+    {
+        buffer->append(text.data(), text.size());
+        FlushIfFull();
+    }
+
+    // Line break followed by the current indentation.
+    void NewLine();
+    // Same as NewLine(), but only when pretty-printing.
+    inline void Break()
+    {
+        if (pretty)
+            NewLine();
+    }
+    inline void Indent() { depth++; }
+    inline void Dedent() { depth--; }
+    inline bool IsPretty() const { return pretty; }
+    inline unsigned int IndentWidth() const { return indentWidth; }
+    inline unsigned int Depth() const { return depth; }
+
+    // Keeps the output from `position` (a Written() value) on in memory, so
+    // it can still be read back or discarded; Release() lets it flush.
+    inline void Hold(size_t position) { hold = position; }
+    inline void Release() { hold = kNoHold; }
+    inline bool Holds(size_t position) const { return hold <= position; }
+    // Held output from `position` to the end.
+    std::string_view Tail(size_t position) const;
+    // Drops the held output from `position` on and restores the indentation.
+    void Rewind(size_t position, unsigned int depth);
+
+    // Pushes buffered output to the stream or file descriptor.
+    void Flush();
+    // Bytes output so far.
+    inline size_t Written() const
+    {
+        return buffer == &chunk ? flushed + chunk.size() : buffer->size() - start;
+    }
+};
+
+// Passed down by the XML serializers: the output, and the element name that
+// array items are written under (the key holding the array). Converts from a
+// plain Writer for the top-level call.
+struct XmlContext
+{
+    Writer &out;
+    std::string_view name;
+
+    XmlContext(Writer &out, std::string_view name = std::string_view()) : out(out), name(name) {}
+};
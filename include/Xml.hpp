@@ -1,9 +1,14 @@
 #pragma once
 #include <iostream>
 #include <string>
-#include <iomanip>
+#include <string_view>
 #include <vector>
-#include <map>
+#include <memory_resource>
+#include "Writer.hpp"
+#include "Number.hpp"
+#include "FlatMap.hpp"
+#include "Escape.hpp"
+#include "Stats.hpp"
 
 namespace Xml
 {
@@ -17,66 +22,78 @@ namespace Xml
         MAP
     };
 
-    class Object    
+    class Object
     {
     protected:
         OBJECT_TYPE type;
+
+        static void writeXmlElement(const XmlContext &context, Object *value);
+
     public:
-        inline static std::string array_name;
-        virtual std::string toXmlString() = 0;
-        virtual std::string toJsonString() = 0;
+        virtual void writeXml(const XmlContext &context) = 0;
+        virtual void writeJson(Writer &out) = 0;
         virtual OBJECT_TYPE getType() { return this->type; }
+        virtual ~Object() = default;
+
+        inline std::string toXmlString()
+        {
+            Stats::Operation operation(Stats::PHASE::SERIALIZE);
+            std::string result;
+            Writer out(result);
+            writeXml(out);
+            Stats::CountBytesEmitted(result.size());
+            return result;
+        }
+        inline std::string toJsonString()
+        {
+            Stats::Operation operation(Stats::PHASE::SERIALIZE);
+            std::string result;
+            Writer out(result);
+            writeJson(out);
+            Stats::CountBytesEmitted(result.size());
+            return result;
+        }
     };
     class XmlString : public Object
     {
     public:
-        std::string value;
+        std::pmr::string value;
 
     public:
-        inline std::string toXmlString() override
-        {
-            return value;
-        }
-        inline std::string toJsonString() override
+        inline void writeXml(const XmlContext &context) override
         {
-            return "\"" + value + "\"";
+            context.out.Write(value);
         }
-        XmlString(std::string value)
+        inline void writeJson(Writer &out) override { WriteXmlTextAsJson(out, value); }
+        XmlString(std::string_view value,
+                  std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : value(value, resource)
         {
-            this->value = value;
             this->type = OBJECT_TYPE::STRING;
         }
     };
     class XmlNumber : public Object
     {
     public:
-        double value;
+        Number value;
 
     public:
-        static std::string shortenDouble(double value, int precision = 6)
+        inline void writeXml(const XmlContext &context) override
         {
-            std::ostringstream out;
-            out << std::fixed << std::setprecision(precision) << value;
-            std::string str = out.str();
-            str.erase(str.find_last_not_of('0') + 1, std::string::npos);
-            if (str.back() == '.')
-            {
-                str.pop_back();
-            }
-
-            return str;
+            this->value.Write(context.out);
         }
-        inline std::string toXmlString() override
+        inline void writeJson(Writer &out) override
         {
-            return shortenDouble(this->value);
+            this->value.Write(out);
         }
-        inline std::string toJsonString() override
+        XmlNumber(double value) : value(value)
         {
-            return shortenDouble(this->value);
+            this->type = OBJECT_TYPE::NUMBER;
         }
-        XmlNumber(double value)
+        XmlNumber(std::string_view lexeme,
+                  std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : value(Number::FromLexeme(lexeme, resource))
         {
-            this->value = value;
             this->type = OBJECT_TYPE::NUMBER;
         }
     };
@@ -86,13 +103,13 @@ namespace Xml
         bool value;
 
     public:
-        inline std::string toXmlString() override
+        inline void writeXml(const XmlContext &context) override
         {
-            return this->value == true ? "true" : "false";
+            context.out.Write(this->value == true ? "true" : "false");
         }
-        inline std::string toJsonString() override
+        inline void writeJson(Writer &out) override
         {
-            return this->value == true ? "true" : "false";
+            out.Write(this->value == true ? "true" : "false");
         }
         XmlBoolean(bool value)
         {
@@ -103,119 +120,168 @@ namespace Xml
     class XmlNull : public Object
     {
     public:
-        inline std::string toXmlString() override
+        inline void writeXml(const XmlContext &context) override
         {
-            return "";
         }
-        inline std::string toJsonString() override
+        inline void writeJson(Writer &out) override
         {
-            return "null";
+            out.Write("null");
         }
         XmlNull()
         {
             this->type = OBJECT_TYPE::NONE;
         }
     };
+    // As with the JSON nodes, containers delete their children; arena trees
+    // are never destroyed.
     class XmlArray : public Object
     {
     private:
-        std::vector<Object *> values;
+        std::pmr::vector<Object *> values;
 
     public:
-        inline std::string toXmlString() override
+        inline void writeXml(const XmlContext &context) override
         {
-            std::ostringstream oss;
             for (size_t i = 0; i < values.size(); ++i)
             {
-                oss << "<" << Object::array_name << ">";
-                oss << values[i]->toXmlString();
-                if (i < values.size() - 1)
-                {
-                    oss << "\n";
-                }
-                oss << "</" << Object::array_name << ">";
-                
+                if (i > 0)
+                    context.out.NewLine();
+                writeXmlElement(context, values[i]);
             }
-            return oss.str();
         }
-        inline std::string toJsonString() override
+        inline void writeJson(Writer &out) override
         {
-            std::ostringstream oss;
-            oss << "[";
-
+            out.Write('[');
+            out.Indent();
             for (size_t i = 0; i < values.size(); ++i)
             {
-                oss << values[i]->toJsonString();
-                if (i < values.size() - 1)
-                {
-                    oss << ",";
-                }
+                if (i > 0)
+                    out.Write(',');
+                out.Break();
+                values[i]->writeJson(out);
             }
-            oss << "]";
-            return oss.str();
+            out.Dedent();
+            if (!values.empty())
+                out.Break();
+            out.Write(']');
         }
+        inline bool Empty() const { return values.empty(); }
         void AddElement(Object *obj)
         {
             values.push_back(obj);
         }
-        XmlArray()
+        XmlArray(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : values(resource)
         {
             this->type = OBJECT_TYPE::ARRAY;
         }
+        ~XmlArray() override
+        {
+            for (Object *value : values)
+                delete value;
+        }
     };
     class XmlMap : public Object
     {
     private:
-        std::map<std::string, Object *> map;
+        FlatMap<Object *> map;
 
     public:
-        XmlMap() { this->type = OBJECT_TYPE::MAP; }
-        inline std::string toXmlString() override
+        XmlMap(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+            : map(resource)
+        {
+            this->type = OBJECT_TYPE::MAP;
+        }
+        ~XmlMap() override
+        {
+            for (auto &entry : map)
+                delete entry.second;
+        }
+        inline void writeXml(const XmlContext &context) override
         {
-            std::ostringstream oss;
             for (auto it = map.begin(); it != map.end(); ++it)
             {
+                if (it != map.begin())
+                    context.out.NewLine();
 
                 if (it->second->getType() == OBJECT_TYPE::ARRAY)
                 {
-                    Object::array_name = it->first;
-                    oss << it->second->toXmlString();
+                    it->second->writeXml(XmlContext(context.out, it->first));
                 }
                 else
                 {
-                    oss << "<" << it->first << ">" << it->second->toXmlString() << "</" << it->first << ">";
-                }
-
-                if (it != std::prev(map.end()))
-                {
-                    oss << "\n";
+                    writeXmlElement(XmlContext(context.out, it->first), it->second);
                 }
             }
-            return oss.str();
         }
-        inline std::string toJsonString() override
+        inline void writeJson(Writer &out) override
         {
-            std::ostringstream oss;
-            oss << "{";
-
+            out.Write('{');
+            out.Indent();
             for (auto it = map.begin(); it != map.end(); ++it)
             {
-                oss << "\"" << it->first << "\":"
-                    << it->second->toJsonString();
-                if (it != std::prev(map.end()))
-                {
-                    oss << ",";
-                }
+                if (it != map.begin())
+                    out.Write(',');
+                out.Break();
+                out.Write('"');
+                out.Write(it->first);
+                out.Write(out.IsPretty() ? "\": " : "\":");
+                it->second->writeJson(out);
             }
-
-            oss << "}";
-            return oss.str();
+            out.Dedent();
+            if (!map.empty())
+                out.Break();
+            out.Write('}');
+        }
+        inline bool Empty() const { return map.empty(); }
+        inline Object *Find(std::string_view key)
+        {
+            Object **value = map.Find(key);
+            return value == nullptr ? nullptr : *value;
         }
-        inline void AddElement(Object *key, Object *value)
+        // The adders return the value a repeated key replaced, or null.
+        inline Object *AddElement(Object *key, Object *value)
         {
             XmlString *str_key = dynamic_cast<XmlString *>(key);
-            map[str_key->value] = value;
+            return map.Set(str_key->value, value);
+        }
+        inline Object *AddElement(std::string_view key, Object *value)
+        {
+            return map.Set(key, value);
+        }
+        // `symbol` comes from a SymbolTable that outlives the map.
+        inline Object *AddSymbol(std::string_view symbol, Object *value)
+        {
+            return map.SetSymbol(symbol, value);
         }
     };
 
+    // Writes <name>value</name>; nested maps and arrays go on their own
+    // indented lines when pretty-printing.
+    inline void Object::writeXmlElement(const XmlContext &context, Object *value)
+    {
+        Writer &out = context.out;
+        bool nested = (value->getType() == OBJECT_TYPE::MAP && !static_cast<XmlMap *>(value)->Empty()) ||
+                      (value->getType() == OBJECT_TYPE::ARRAY && !static_cast<XmlArray *>(value)->Empty());
+
+        out.Write('<');
+        out.Write(context.name);
+        out.Write('>');
+        if (nested)
+        {
+            out.Indent();
+            out.Break();
+            value->writeXml(context);
+            out.Dedent();
+            out.Break();
+        }
+        else
+        {
+            value->writeXml(context);
+        }
+        out.Write("</");
+        out.Write(context.name);
+        out.Write('>');
+    }
+
 } // namespace Xml
@@ -0,0 +1,92 @@
+#include "Arena.hpp"
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+    constexpr size_t kMaxBlockSize = 16 * 1024 * 1024;
+
+    char *AlignUp(char *ptr, size_t alignment)
+    {
+        uintptr_t value = reinterpret_cast<uintptr_t>(ptr);
+        return reinterpret_cast<char *>((value + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+}
+
+Arena::Arena(size_t initialBlockSize)
+    : head(nullptr), cursor(nullptr), end(nullptr), nextBlockSize(initialBlockSize)
+{
+}
+
+Arena::~Arena()
+{
+    Release();
+}
+
+void Arena::Grow(size_t bytes, size_t alignment)
+{
+    size_t needed = sizeof(Block) + bytes + alignment;
+    size_t size = nextBlockSize > needed ? nextBlockSize : needed;
+
+    Block *block = static_cast<Block *>(std::malloc(size));
+    if (block == nullptr)
+        throw std::bad_alloc();
+    block->next = head;
+    block->size = size;
+    head = block;
+
+    cursor = reinterpret_cast<char *>(block + 1);
+    end = reinterpret_cast<char *>(block) + size;
+
+    if (nextBlockSize < kMaxBlockSize)
+        nextBlockSize *= 2;
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    char *ptr = AlignUp(cursor, alignment);
+    if (cursor == nullptr || ptr + bytes > end)
+    {
+        Grow(bytes, alignment);
+        ptr = AlignUp(cursor, alignment);
+    }
+    cursor = ptr + bytes;
+    return ptr;
+}
+
+void Arena::Release()
+{
+    while (head != nullptr)
+    {
+        Block *next = head->next;
+        std::free(head);
+        head = next;
+    }
+    cursor = nullptr;
+    end = nullptr;
+}
+
+void Arena::Reset()
+{
+    if (head == nullptr)
+        return;
+
+    if (head->next != nullptr)
+    {
+        // Trade the blocks for a single one as large as all of them.
+        size_t total = BytesReserved();
+        Release();
+        Grow(total, 1);
+        return;
+    }
+    cursor = reinterpret_cast<char *>(head + 1);
+    end = reinterpret_cast<char *>(head) + head->size;
+}
+
+size_t Arena::BytesReserved() const
+{
+    size_t total = 0;
+    for (Block *block = head; block != nullptr; block = block->next)
+        total += block->size;
+    return total;
+}
@@ -0,0 +1,349 @@
+#include "Batch.hpp"
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include "Parser.hpp"
+#include "Simd.hpp"
+
+namespace
+{
+    bool IsBlank(std::string_view text)
+    {
+        return text.find_first_not_of(" \t\r\n") == std::string_view::npos;
+    }
+
+    // Small records get a small first arena block; large ones start with room
+    // for roughly their node count.
+    size_t InitialBlockSize(std::string_view record)
+    {
+        size_t size = 4 * record.size();
+        if (size < 1024)
+            return 1024;
+        if (size > 64 * 1024)
+            return 64 * 1024;
+        return size;
+    }
+
+    // Groups consecutive slices into tasks of about kTaskBytes, as [first, last).
+    std::vector<std::pair<size_t, size_t>> GroupTasks(const std::vector<std::string_view> &slices)
+    {
+        std::vector<std::pair<size_t, size_t>> tasks;
+        size_t first = 0;
+        while (first < slices.size())
+        {
+            size_t last = first;
+            size_t bytes = 0;
+            while (last < slices.size() && (last == first || bytes < BatchParser::kTaskBytes))
+                bytes += slices[last++].size();
+            tasks.emplace_back(first, last);
+            first = last;
+        }
+        return tasks;
+    }
+
+    // Remembers the lowest failing record so the reported error does not
+    // depend on scheduling.
+    struct FirstError
+    {
+        const char *label;
+        std::mutex mutex;
+        size_t record = 0;
+        std::string message;
+        bool failed = false;
+
+        explicit FirstError(const char *label) : label(label) {}
+
+        void Set(size_t index, const char *what)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failed || index < record)
+            {
+                failed = true;
+                record = index;
+                message = what;
+            }
+        }
+
+        void Rethrow()
+        {
+            if (failed)
+                throw std::runtime_error(label + std::to_string(record) + ": " + message);
+        }
+    };
+
+    template <typename DocumentT, typename ParseFn>
+    void ParseRecords(ThreadPool &pool, const std::vector<std::string_view> &records, ParseFn parse,
+                      const std::function<void(size_t, DocumentT &)> &callback)
+    {
+        FirstError error("Record ");
+        for (auto [first, last] : GroupTasks(records))
+        {
+            pool.Submit([&, first = first, last = last]
+                        {
+                            Parser parser;
+                            for (size_t i = first; i < last; i++)
+                            {
+                                try
+                                {
+                                    DocumentT document(InitialBlockSize(records[i]));
+                                    document.SetRoot(parse(parser, records[i], document.GetArena()));
+                                    callback(i, document);
+                                }
+                                catch (const std::exception &e)
+                                {
+                                    error.Set(i, e.what());
+                                }
+                            } });
+        }
+        pool.Wait();
+        error.Rethrow();
+    }
+
+    Json::Object *ParseJsonRecord(Parser &parser, std::string_view record, Arena &arena)
+    {
+        return parser.ParseJson(record, arena);
+    }
+
+    Xml::Object *ParseXmlRecord(Parser &parser, std::string_view record, Arena &arena)
+    {
+        return parser.ParseXml(record, arena);
+    }
+
+    // Index just past the '>' closing the markup that starts at `pos`, or
+    // npos if it is unterminated. Quoted attribute values may contain '>'.
+    size_t SkipTag(std::string_view input, size_t pos)
+    {
+        char quote = 0;
+        for (size_t i = pos + 1; i < input.size(); i++)
+        {
+            char c = input[i];
+            if (quote != 0)
+            {
+                if (c == quote)
+                    quote = 0;
+            }
+            else if (c == '"' || c == '\'')
+                quote = c;
+            else if (c == '>')
+                return i + 1;
+        }
+        return std::string_view::npos;
+    }
+
+    size_t SkipPast(std::string_view input, size_t pos, std::string_view terminator)
+    {
+        size_t found = input.find(terminator, pos);
+        return found == std::string_view::npos ? found : found + terminator.size();
+    }
+}
+
+std::vector<std::string_view> SplitJsonLines(std::string_view input)
+{
+    std::vector<std::string_view> records;
+    size_t pos = 0;
+    while (pos < input.size())
+    {
+        size_t newline = input.find('\n', pos);
+        if (newline == std::string_view::npos)
+            newline = input.size();
+
+        std::string_view line = input.substr(pos, newline - pos);
+        if (!IsBlank(line))
+            records.push_back(line);
+        pos = newline + 1;
+    }
+    return records;
+}
+
+std::vector<std::string_view> SplitXmlDocuments(std::string_view input)
+{
+    std::vector<std::string_view> records;
+    size_t start = std::string_view::npos;
+    size_t depth = 0;
+    size_t pos = 0;
+
+    while ((pos = input.find('<', pos)) != std::string_view::npos)
+    {
+        if (start == std::string_view::npos)
+            start = pos;
+
+        std::string_view rest = input.substr(pos);
+        size_t end;
+        bool closesRoot = false;
+        if (rest.compare(0, 4, "<!--") == 0)
+            end = SkipPast(input, pos + 4, "-->");
+        else if (rest.compare(0, 9, "<![CDATA[") == 0)
+            end = SkipPast(input, pos + 9, "]]>");
+        else if (rest.compare(0, 2, "<?") == 0)
+            end = SkipPast(input, pos + 2, "?>");
+        else if (rest.compare(0, 2, "<!") == 0)
+            end = SkipTag(input, pos);
+        else
+        {
+            end = SkipTag(input, pos);
+            if (end == std::string_view::npos)
+                break;
+
+            if (rest[1] == '/')
+            {
+                if (depth > 0)
+                    depth--;
+                closesRoot = depth == 0;
+            }
+            else if (input[end - 2] == '/')
+                closesRoot = depth == 0;
+            else
+                depth++;
+        }
+
+        if (end == std::string_view::npos)
+            break;
+        if (closesRoot)
+        {
+            records.push_back(input.substr(start, end - start));
+            start = std::string_view::npos;
+        }
+        pos = end;
+    }
+
+    // Whatever is left is an incomplete document; let the parser report it.
+    if (start != std::string_view::npos && !IsBlank(input.substr(start)))
+        records.push_back(input.substr(start));
+    return records;
+}
+
+std::vector<std::string_view> SplitJsonArray(std::string_view input)
+{
+    size_t open = Simd::SkipWhitespace(input.data(), 0, input.size());
+    if (open == input.size() || input[open] != '[')
+        throw std::runtime_error("Expected a JSON array");
+
+    std::vector<std::string_view> elements;
+    Simd::StringScanner strings;
+    Simd::BlockMasks masks;
+    size_t depth = 0;
+    size_t start = open + 1;
+
+    for (size_t block = open; block < input.size(); block += Simd::kBlockSize)
+    {
+        size_t length = input.size() - block < Simd::kBlockSize ? input.size() - block : Simd::kBlockSize;
+        Simd::Classify(input.data() + block, length, masks);
+        uint64_t structural = masks.structural & ~strings.Next(masks);
+
+        while (structural != 0)
+        {
+            size_t pos = block + __builtin_ctzll(structural);
+            structural &= structural - 1;
+
+            switch (input[pos])
+            {
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                if (--depth == 0)
+                {
+                    // A brace here closes the array, as the sequential parser
+                    // would report after the last item.
+                    if (input[pos] != ']')
+                        throw std::runtime_error("Expected , or closing bracket");
+                    std::string_view last = input.substr(start, pos - start);
+                    if (!elements.empty() || !IsBlank(last))
+                        elements.push_back(last);
+                    if (!IsBlank(input.substr(pos + 1)))
+                        throw std::runtime_error("Unexpected data after document");
+                    return elements;
+                }
+                break;
+            case ',':
+                if (depth == 1)
+                {
+                    elements.push_back(input.substr(start, pos - start));
+                    start = pos + 1;
+                }
+                break;
+            }
+        }
+    }
+    throw std::runtime_error("Unexpected end of input");
+}
+
+std::vector<Json::Document> BatchParser::ParseJsonLines(std::string_view input)
+{
+    std::vector<std::string_view> records = SplitJsonLines(input);
+    std::vector<Json::Document> documents(records.size());
+    ParseRecords<Json::Document>(pool, records, ParseJsonRecord,
+                                 [&documents](size_t index, Json::Document &document)
+                                 { documents[index] = std::move(document); });
+    return documents;
+}
+
+std::vector<Xml::Document> BatchParser::ParseXmlDocuments(std::string_view input)
+{
+    std::vector<std::string_view> records = SplitXmlDocuments(input);
+    std::vector<Xml::Document> documents(records.size());
+    ParseRecords<Xml::Document>(pool, records, ParseXmlRecord,
+                                [&documents](size_t index, Xml::Document &document)
+                                { documents[index] = std::move(document); });
+    return documents;
+}
+
+void BatchParser::ParseJsonLines(std::string_view input, const std::function<void(size_t, Json::Document &)> &callback)
+{
+    ParseRecords<Json::Document>(pool, SplitJsonLines(input), ParseJsonRecord, callback);
+}
+
+void BatchParser::ParseXmlDocuments(std::string_view input, const std::function<void(size_t, Xml::Document &)> &callback)
+{
+    ParseRecords<Xml::Document>(pool, SplitXmlDocuments(input), ParseXmlRecord, callback);
+}
+
+Json::Document BatchParser::ParseJsonArray(std::string_view input)
+{
+    size_t open = Simd::SkipWhitespace(input.data(), 0, input.size());
+    if (open == input.size() || input[open] != '[')
+    {
+        Parser parser;
+        return parser.ParseJsonDocument(input);
+    }
+
+    std::vector<std::string_view> elements = SplitJsonArray(input);
+    std::vector<std::pair<size_t, size_t>> tasks = GroupTasks(elements);
+    std::vector<std::unique_ptr<Arena>> arenas(tasks.size());
+
+    Json::Document document;
+    Json::JsonArray *array = document.GetArena().Create<Json::JsonArray>();
+    array->values.resize(elements.size());
+
+    FirstError error("Element ");
+    for (size_t task = 0; task < tasks.size(); task++)
+    {
+        pool.Submit([&, task]
+                    {
+                        arenas[task] = std::make_unique<Arena>();
+                        SymbolTable symbols(*arenas[task]);
+                        Parser parser;
+                        parser.SetSymbolTable(&symbols);
+                        for (size_t i = tasks[task].first; i < tasks[task].second; i++)
+                        {
+                            try
+                            {
+                                array->values[i] = parser.ParseJson(elements[i], *arenas[task]);
+                            }
+                            catch (const std::exception &e)
+                            {
+                                error.Set(i, e.what());
+                            }
+                        } });
+    }
+    pool.Wait();
+    error.Rethrow();
+
+    for (std::unique_ptr<Arena> &arena : arenas)
+        document.Adopt(std::move(arena));
+    document.SetRoot(array);
+    return document;
+}
@@ -0,0 +1,186 @@
+#include "Bind.hpp"
+#include "Escape.hpp"
+#include "Number.hpp"
+#include "Simd.hpp"
+
+namespace Bind
+{
+    namespace Detail
+    {
+        JsonCursor::JsonCursor(std::string_view input) : input(input), lexer(input)
+        {
+            if (!lexer.NextToken(token))
+                throw std::runtime_error("Empty input");
+        }
+
+        const TokenJson &JsonCursor::Next()
+        {
+            if (!lexer.NextToken(token))
+                throw std::runtime_error("Unexpected end of input");
+            return token;
+        }
+
+        void JsonCursor::Skip()
+        {
+            TOKEN_TYPE close;
+            if (token.type == TOKEN_TYPE::BRACE_OPEN)
+                close = TOKEN_TYPE::BRACE_CLOSE;
+            else if (token.type == TOKEN_TYPE::BRACKET_OPEN)
+                close = TOKEN_TYPE::BRACKET_CLOSE;
+            else
+                return;
+
+            size_t end = Simd::MatchClose(input.data(), lexer.Position() - 1, input.size());
+            if (end == input.size())
+                throw std::runtime_error("Unexpected end of input");
+            lexer.Seek(end + 1);
+            token = TokenJson(close, input.substr(end, 1));
+        }
+
+        void JsonCursor::Finish()
+        {
+            if (lexer.NextToken(token))
+                throw std::runtime_error("Unexpected data after document");
+        }
+
+        XmlCursor::XmlCursor(std::string_view input) : lexer(input)
+        {
+            if (!lexer.NextToken(token))
+                throw std::runtime_error("Empty input");
+            if (token.type != TOKEN_TYPE::TAG_OPEN)
+                throw std::runtime_error("Text outside of the root element");
+        }
+
+        const TokenXml &XmlCursor::Next()
+        {
+            if (!lexer.NextToken(token))
+                throw std::runtime_error("Unexpected end of input");
+            return token;
+        }
+
+        void XmlCursor::SkipElement()
+        {
+            std::string_view text;
+            Text(text);
+        }
+
+        bool XmlCursor::Text(std::string_view &text)
+        {
+            std::string_view name = token.value;
+            bool found = false;
+            size_t depth = 0;
+            while (true)
+            {
+                Next();
+                if (token.type == TOKEN_TYPE::TAG_OPEN)
+                {
+                    depth++;
+                }
+                else if (token.type == TOKEN_TYPE::TAG_CLOSE)
+                {
+                    if (depth == 0)
+                        break;
+                    depth--;
+                }
+                else if (depth == 0)
+                {
+                    text = token.value;
+                    found = true;
+                }
+            }
+            if (token.value != name)
+                throw std::runtime_error("Mismatched closing tag: " + std::string(token.value));
+            return found;
+        }
+
+        void XmlCursor::Finish()
+        {
+            if (lexer.NextToken(token))
+                throw std::runtime_error("Unexpected data after document");
+        }
+
+        void FromJson(const TokenJson &token, bool &value)
+        {
+            if (token.type == TOKEN_TYPE::TRUE)
+                value = true;
+            else if (token.type == TOKEN_TYPE::FALSE)
+                value = false;
+            else
+                throw std::runtime_error("Expected boolean");
+        }
+
+        void FromJson(const TokenJson &token, int64_t &value)
+        {
+            if (token.type != TOKEN_TYPE::NUMBER || !ParseInteger(token.value, value))
+                throw std::runtime_error("Expected integer");
+        }
+
+        void FromJson(const TokenJson &token, uint64_t &value)
+        {
+            if (token.type != TOKEN_TYPE::NUMBER || !ParseInteger(token.value, value))
+                throw std::runtime_error("Expected unsigned integer");
+        }
+
+        void FromJson(const TokenJson &token, double &value)
+        {
+            if (token.type != TOKEN_TYPE::NUMBER || !ParseDouble(token.value, value))
+                throw std::runtime_error("Expected number");
+        }
+
+        void FromJson(const TokenJson &token, std::string &value)
+        {
+            if (token.type != TOKEN_TYPE::STRING)
+                throw std::runtime_error("Expected string");
+            if (token.value.find('\\') == std::string_view::npos)
+                value.assign(token.value);
+            else
+                value = UnescapeJson(token.value);
+        }
+
+        void FromXml(std::string_view text, bool &value)
+        {
+            if (isBooleanTrue(text))
+                value = true;
+            else if (isBooleanFalse(text))
+                value = false;
+            else
+                throw std::runtime_error("Expected boolean");
+        }
+
+        void FromXml(std::string_view text, int64_t &value)
+        {
+            if (!ParseInteger(text, value))
+                throw std::runtime_error("Expected integer");
+        }
+
+        void FromXml(std::string_view text, uint64_t &value)
+        {
+            if (!ParseInteger(text, value))
+                throw std::runtime_error("Expected unsigned integer");
+        }
+
+        void FromXml(std::string_view text, double &value)
+        {
+            if (!ParseDouble(text, value))
+                throw std::runtime_error("Expected number");
+        }
+
+        void FromXml(std::string_view text, std::string &value)
+        {
+            if (text.find('&') == std::string_view::npos)
+                value.assign(text);
+            else
+                value = UnescapeXml(text);
+        }
+
+        bool IsXmlNull(std::string_view text)
+        {
+            return isNull(text);
+        }
+
+        void Rethrow(std::string_view member, const std::exception &error)
+        {
+            throw std::runtime_error(std::string(member) + ": " + error.what());
+        }
+    } // namespace Detail
+} // namespace Bind
@@ -0,0 +1,266 @@
+#include "Escape.hpp"
+#include <stdexcept>
+
+namespace
+{
+    unsigned int ReadHex4(std::string_view raw, size_t pos)
+    {
+        if (pos + 4 > raw.size())
+            throw std::runtime_error("Truncated \\u escape");
+
+        unsigned int code = 0;
+        for (size_t i = pos; i < pos + 4; i++)
+        {
+            char c = raw[i];
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+                code |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                code |= c - 'A' + 10;
+            else
+                throw std::runtime_error("Invalid \\u escape");
+        }
+        return code;
+    }
+
+    void AppendUtf8(std::string &out, unsigned int code)
+    {
+        if (code < 0x80)
+        {
+            out += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+}
+
+std::string UnescapeJson(std::string_view raw)
+{
+    size_t escape = raw.find('\\');
+    if (escape == std::string_view::npos)
+        return std::string(raw);
+
+    std::string out;
+    out.reserve(raw.size());
+    size_t pos = 0;
+
+    while (escape != std::string_view::npos)
+    {
+        out.append(raw.data() + pos, escape - pos);
+        if (escape + 1 >= raw.size())
+            throw std::runtime_error("Truncated escape sequence");
+
+        char c = raw[escape + 1];
+        pos = escape + 2;
+        switch (c)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            out += c;
+            break;
+        case 'b':
+            out += '\b';
+            break;
+        case 'f':
+            out += '\f';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 't':
+            out += '\t';
+            break;
+        case 'u':
+        {
+            unsigned int code = ReadHex4(raw, pos);
+            pos += 4;
+            if (code >= 0xD800 && code <= 0xDBFF && pos + 6 <= raw.size() &&
+                raw[pos] == '\\' && raw[pos + 1] == 'u')
+            {
+                unsigned int low = ReadHex4(raw, pos + 2);
+                if (low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    pos += 6;
+                }
+            }
+            AppendUtf8(out, code);
+            break;
+        }
+        default:
+            throw std::runtime_error(std::string("Invalid escape sequence \\") + c);
+        }
+        escape = raw.find('\\', pos);
+    }
+    out.append(raw.data() + pos, raw.size() - pos);
+    return out;
+}
+
+std::string UnescapeXml(std::string_view raw)
+{
+    size_t amp = raw.find('&');
+    if (amp == std::string_view::npos)
+        return std::string(raw);
+
+    std::string out;
+    out.reserve(raw.size());
+    size_t pos = 0;
+
+    while (amp != std::string_view::npos)
+    {
+        out.append(raw.data() + pos, amp - pos);
+        pos = amp;
+
+        size_t semi = raw.find(';', amp);
+        if (semi == std::string_view::npos)
+            break;
+        std::string_view name = raw.substr(amp + 1, semi - amp - 1);
+
+        if (name == "amp")
+            out += '&';
+        else if (name == "lt")
+            out += '<';
+        else if (name == "gt")
+            out += '>';
+        else if (name == "quot")
+            out += '"';
+        else if (name == "apos")
+            out += '\'';
+        else if (name.size() > 1 && name[0] == '#')
+        {
+            bool hex = name[1] == 'x' || name[1] == 'X';
+            unsigned int code = 0;
+            bool valid = name.size() > (hex ? 2u : 1u);
+            for (size_t i = hex ? 2 : 1; i < name.size() && valid; i++)
+            {
+                char c = name[i];
+                if (c >= '0' && c <= '9')
+                    code = code * (hex ? 16 : 10) + (c - '0');
+                else if (hex && c >= 'a' && c <= 'f')
+                    code = code * 16 + (c - 'a' + 10);
+                else if (hex && c >= 'A' && c <= 'F')
+                    code = code * 16 + (c - 'A' + 10);
+                else
+                    valid = false;
+                if (code > 0x10FFFF)
+                    valid = false;
+            }
+            if (!valid)
+            {
+                amp = raw.find('&', amp + 1);
+                continue;
+            }
+            AppendUtf8(out, code);
+        }
+        else
+        {
+            amp = raw.find('&', amp + 1);
+            continue;
+        }
+
+        pos = semi + 1;
+        amp = raw.find('&', pos);
+    }
+    out.append(raw.data() + pos, raw.size() - pos);
+    return out;
+}
+
+void WriteJsonEscaped(Writer &out, std::string_view text)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        unsigned char c = text[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        out.Write(text.substr(run, i - run));
+        run = i + 1;
+        switch (c)
+        {
+        case '"':
+            out.Write("\\\"");
+            break;
+        case '\\':
+            out.Write("\\\\");
+            break;
+        case '\n':
+            out.Write("\\n");
+            break;
+        case '\r':
+            out.Write("\\r");
+            break;
+        case '\t':
+            out.Write("\\t");
+            break;
+        case '\b':
+            out.Write("\\b");
+            break;
+        case '\f':
+            out.Write("\\f");
+            break;
+        default:
+        {
+            char escape[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+            out.Write(std::string_view(escape, sizeof(escape)));
+            break;
+        }
+        }
+    }
+    out.Write(text.substr(run));
+}
+
+void WriteXmlEscaped(Writer &out, std::string_view text)
+{
+    size_t run = 0;
+    size_t i = text.find_first_of("&<>");
+    while (i != std::string_view::npos)
+    {
+        out.Write(text.substr(run, i - run));
+        out.Write(text[i] == '&' ? "&amp;" : text[i] == '<' ? "&lt;" : "&gt;");
+        run = i + 1;
+        i = text.find_first_of("&<>", run);
+    }
+    out.Write(text.substr(run));
+}
+
+void WriteJsonStringAsXml(Writer &out, std::string_view raw)
+{
+    if (raw.find('\\') == std::string_view::npos)
+        WriteXmlEscaped(out, raw);
+    else
+        WriteXmlEscaped(out, UnescapeJson(raw));
+}
+
+void WriteXmlTextAsJson(Writer &out, std::string_view raw)
+{
+    out.Write('"');
+    if (raw.find('&') == std::string_view::npos)
+        WriteJsonEscaped(out, raw);
+    else
+        WriteJsonEscaped(out, UnescapeXml(raw));
+    out.Write('"');
+}
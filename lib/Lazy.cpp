@@ -0,0 +1,228 @@
+#include "Lazy.hpp"
+#include <stdexcept>
+#include "Parser.hpp"
+#include "Simd.hpp"
+#include "Stats.hpp"
+#include "Tokenizer.hpp"
+
+namespace
+{
+    // An object or array known only by its text, from the opening bracket
+    // to the matching close. Never handed out: refs expand it first.
+    class Unparsed : public Json::Object
+    {
+    public:
+        std::string_view text;
+
+        Unparsed(std::string_view text) : text(text)
+        {
+            this->type = text[0] == '{' ? Json::OBJECT_TYPE::MAP : Json::OBJECT_TYPE::ARRAY;
+        }
+        void writeXml(const XmlContext &) override { throw std::runtime_error("Lazy value written before parsing"); }
+        void writeJson(Writer &) override { throw std::runtime_error("Lazy value written before parsing"); }
+    };
+
+    // Text of the container opening at text[open], or throws if unclosed.
+    std::string_view Delimit(std::string_view text, size_t open)
+    {
+        size_t close = Simd::MatchClose(text.data(), open, text.size());
+        if (close == text.size())
+            throw std::runtime_error("Unexpected end of input");
+        return text.substr(open, close + 1 - open);
+    }
+
+    void NextToken(JsonLexer &lexer, TokenJson &token)
+    {
+        if (!lexer.NextToken(token))
+            throw std::runtime_error("Unexpected end of input");
+    }
+
+    // Scalars are parsed; nested containers are skipped past their close.
+    Json::Object *ParseValue(Arena &arena, std::string_view text, JsonLexer &lexer, const TokenJson &token)
+    {
+        Stats::CountNode();
+        switch (token.type)
+        {
+        case TOKEN_TYPE::STRING:
+            return arena.Create<Json::JsonString>(token.value);
+        case TOKEN_TYPE::NUMBER:
+            return arena.Create<Json::JsonNumber>(token.value);
+        case TOKEN_TYPE::TRUE:
+            return arena.Create<Json::JsonBoolean>(true);
+        case TOKEN_TYPE::FALSE:
+            return arena.Create<Json::JsonBoolean>(false);
+        case TOKEN_TYPE::NONE:
+            return arena.Create<Json::JsonNull>();
+        case TOKEN_TYPE::BRACE_OPEN:
+        case TOKEN_TYPE::BRACKET_OPEN:
+        {
+            std::string_view nested = Delimit(text, lexer.Position() - 1);
+            lexer.Seek(lexer.Position() - 1 + nested.size());
+            return arena.Create<Unparsed>(nested);
+        }
+        default:
+            throw std::runtime_error("unexpected token");
+        }
+    }
+
+    // Parses one level of `text`, a whole object or array.
+    Json::Object *Expand(Arena &arena, std::string_view text)
+    {
+        Stats::Operation operation(Stats::PHASE::PARSE);
+        Stats::CountBytesParsed(text.size());
+        Stats::CountNode();
+        JsonLexer lexer(text);
+        TokenJson token;
+        NextToken(lexer, token);
+        bool isMap = token.type == TOKEN_TYPE::BRACE_OPEN;
+        TOKEN_TYPE close = isMap ? TOKEN_TYPE::BRACE_CLOSE : TOKEN_TYPE::BRACKET_CLOSE;
+        Json::JsonMap *map = isMap ? arena.Create<Json::JsonMap>() : nullptr;
+        Json::JsonArray *array = isMap ? nullptr : arena.Create<Json::JsonArray>();
+
+        NextToken(lexer, token);
+        while (token.type != close)
+        {
+            std::string_view key;
+            if (isMap)
+            {
+                if (token.type != TOKEN_TYPE::STRING)
+                    throw std::runtime_error("Expected string key in object");
+                key = token.value;
+                NextToken(lexer, token);
+                if (token.type != TOKEN_TYPE::COLON)
+                    throw std::runtime_error("Expected : in key-value pair");
+                NextToken(lexer, token);
+            }
+
+            Json::Object *value = ParseValue(arena, text, lexer, token);
+            if (isMap)
+                map->AddSymbol(key, value); // keys stay in the source text
+            else
+                array->AddElement(value);
+
+            // Same separator rules and messages as Parser::ParseJsonObject
+            // and ParseJsonArray.
+            NextToken(lexer, token);
+            if (token.type == close)
+                break;
+            if (token.type != TOKEN_TYPE::COMMA)
+                throw std::runtime_error("Expected , or closing bracket");
+            NextToken(lexer, token);
+            if (isMap && token.type != TOKEN_TYPE::STRING)
+                throw std::runtime_error("Expected string key in object");
+            if (!isMap && token.type == close)
+                throw std::runtime_error("unexpected token");
+        }
+        if (lexer.Position() != text.size())
+            throw std::runtime_error("Mismatched brackets");
+
+        if (isMap)
+            return map;
+        return array;
+    }
+
+    void Materialize(Parser &parser, Arena &arena, Json::Object **slot)
+    {
+        if (Unparsed *unparsed = dynamic_cast<Unparsed *>(*slot))
+        {
+            *slot = parser.ParseJson(unparsed->text, arena);
+            return;
+        }
+        if ((*slot)->getType() == Json::OBJECT_TYPE::MAP)
+        {
+            for (auto &member : static_cast<Json::JsonMap *>(*slot)->map)
+                Materialize(parser, arena, &member.second);
+        }
+        else if ((*slot)->getType() == Json::OBJECT_TYPE::ARRAY)
+        {
+            for (Json::Object *&value : static_cast<Json::JsonArray *>(*slot)->values)
+                Materialize(parser, arena, &value);
+        }
+    }
+}
+
+namespace Json
+{
+    Object *LazyRef::Expanded() const
+    {
+        if (slot == nullptr)
+            throw std::runtime_error("Invalid ref");
+        if (Unparsed *unparsed = dynamic_cast<Unparsed *>(*slot))
+            *slot = Expand(*arena, unparsed->text);
+        return *slot;
+    }
+
+    OBJECT_TYPE LazyRef::getType() const
+    {
+        if (slot == nullptr)
+            throw std::runtime_error("Invalid ref");
+        return (*slot)->getType();
+    }
+
+    size_t LazyRef::Size() const
+    {
+        Object *value = Expanded();
+        if (value->getType() == OBJECT_TYPE::MAP)
+            return static_cast<JsonMap *>(value)->map.size();
+        if (value->getType() == OBJECT_TYPE::ARRAY)
+            return static_cast<JsonArray *>(value)->values.size();
+        return 0;
+    }
+
+    LazyRef LazyRef::operator[](size_t index) const
+    {
+        if (slot == nullptr)
+            return LazyRef();
+        Object *value = Expanded();
+        if (value->getType() != OBJECT_TYPE::ARRAY)
+            throw std::runtime_error("Not an array");
+
+        std::pmr::vector<Object *> &values = static_cast<JsonArray *>(value)->values;
+        return index < values.size() ? LazyRef(arena, &values[index]) : LazyRef();
+    }
+
+    LazyRef LazyRef::operator[](std::string_view key) const
+    {
+        if (slot == nullptr)
+            return LazyRef();
+        Object *value = Expanded();
+        if (value->getType() != OBJECT_TYPE::MAP)
+            throw std::runtime_error("Not an object");
+
+        Object **member = static_cast<JsonMap *>(value)->map.Find(key);
+        return member != nullptr ? LazyRef(arena, member) : LazyRef();
+    }
+
+    Object *LazyRef::Get() const
+    {
+        if (slot == nullptr)
+            throw std::runtime_error("Invalid ref");
+        Stats::Operation operation(Stats::PHASE::PARSE);
+        Parser parser;
+        Materialize(parser, *arena, slot);
+        return *slot;
+    }
+
+    LazyDocument::LazyDocument(std::string_view jsonString)
+        : arena(std::make_unique<Arena>()), root(nullptr)
+    {
+        Stats::Operation operation(Stats::PHASE::PARSE);
+        Stats::CountBytesParsed(jsonString.size());
+        root = static_cast<Object **>(arena->allocate(sizeof(Object *), alignof(Object *)));
+
+        size_t start = Simd::SkipWhitespace(jsonString.data(), 0, jsonString.size());
+        if (start < jsonString.size() && (jsonString[start] == '{' || jsonString[start] == '['))
+        {
+            std::string_view text = Delimit(jsonString, start);
+            size_t rest = start + text.size();
+            if (Simd::SkipWhitespace(jsonString.data(), rest, jsonString.size()) != jsonString.size())
+                throw std::runtime_error("Unexpected data after document");
+            *root = arena->Create<Unparsed>(text);
+        }
+        else
+        {
+            Parser parser;
+            *root = parser.ParseJson(jsonString, *arena);
+        }
+    }
+} // namespace Json
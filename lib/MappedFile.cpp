@@ -0,0 +1,90 @@
+#include "MappedFile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path) : data(nullptr), size(0), mapped(false)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Could not open file " + path + ": " + std::strerror(errno));
+
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *address = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED)
+        {
+            ::madvise(address, info.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(address);
+            size = info.st_size;
+            mapped = true;
+            ::close(fd);
+            return;
+        }
+    }
+
+    char chunk[64 * 1024];
+    while (true)
+    {
+        ssize_t count = ::read(fd, chunk, sizeof(chunk));
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("Could not read file " + path + ": " + std::strerror(error));
+        }
+        if (count == 0)
+            break;
+        buffer.append(chunk, count);
+    }
+    ::close(fd);
+    data = buffer.data();
+    size = buffer.size();
+}
+
+MappedFile::~MappedFile()
+{
+    Unmap();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data(other.data), size(other.size), mapped(other.mapped), buffer(std::move(other.buffer))
+{
+    if (!mapped)
+        data = buffer.data();
+    other.data = nullptr;
+    other.size = 0;
+    other.mapped = false;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        Unmap();
+        mapped = other.mapped;
+        size = other.size;
+        buffer = std::move(other.buffer);
+        data = mapped ? other.data : buffer.data();
+        other.data = nullptr;
+        other.size = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+void MappedFile::Unmap()
+{
+    if (mapped)
+        ::munmap(const_cast<char *>(data), size);
+    data = nullptr;
+    size = 0;
+    mapped = false;
+}
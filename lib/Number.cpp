@@ -0,0 +1,294 @@
+#include "Number.hpp"
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    constexpr double kPowersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    constexpr uint64_t kMaxExactMantissa = uint64_t(1) << 53;
+
+    inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+    // Accumulates the digits of `text` into `value`; fails on anything else or
+    // on overflow.
+    bool ParseDigits(std::string_view text, uint64_t &value)
+    {
+        if (text.empty())
+            return false;
+
+        uint64_t result = 0;
+        for (char c : text)
+        {
+            if (!IsDigit(c))
+                return false;
+            uint64_t digit = c - '0';
+            if (result > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+                return false;
+            result = result * 10 + digit;
+        }
+        value = result;
+        return true;
+    }
+}
+
+bool IsNumberLexeme(std::string_view text)
+{
+    size_t pos = 0;
+    size_t size = text.size();
+
+    if (pos < size && text[pos] == '-')
+        pos++;
+
+    size_t digits = pos;
+    while (pos < size && IsDigit(text[pos]))
+        pos++;
+    if (pos == digits)
+        return false;
+
+    if (pos < size && text[pos] == '.')
+    {
+        digits = ++pos;
+        while (pos < size && IsDigit(text[pos]))
+            pos++;
+        if (pos == digits)
+            return false;
+    }
+
+    if (pos < size && (text[pos] == 'e' || text[pos] == 'E'))
+    {
+        pos++;
+        if (pos < size && (text[pos] == '+' || text[pos] == '-'))
+            pos++;
+        digits = pos;
+        while (pos < size && IsDigit(text[pos]))
+            pos++;
+        if (pos == digits)
+            return false;
+    }
+
+    return pos == size;
+}
+
+bool ParseInteger(std::string_view text, uint64_t &value)
+{
+    return ParseDigits(text, value);
+}
+
+bool ParseInteger(std::string_view text, int64_t &value)
+{
+    bool negative = !text.empty() && text[0] == '-';
+    uint64_t magnitude;
+    if (!ParseDigits(negative ? text.substr(1) : text, magnitude))
+        return false;
+
+    if (negative)
+    {
+        if (magnitude > uint64_t(std::numeric_limits<int64_t>::max()) + 1)
+            return false;
+        value = static_cast<int64_t>(0 - magnitude);
+    }
+    else
+    {
+        if (magnitude > uint64_t(std::numeric_limits<int64_t>::max()))
+            return false;
+        value = static_cast<int64_t>(magnitude);
+    }
+    return true;
+}
+
+bool ParseDouble(std::string_view text, double &value)
+{
+    size_t pos = 0;
+    size_t size = text.size();
+    bool negative = false;
+
+    if (pos < size && text[pos] == '-')
+    {
+        negative = true;
+        pos++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool exact = true;
+    // Decimal order of magnitude of the leading digit, for out-of-range
+    // results: integer digits past the first, or fraction zeros before it.
+    int integerDigits = 0;
+    int leadingZeros = 0;
+    bool nonZero = false;
+
+    for (; pos < size && IsDigit(text[pos]); pos++)
+    {
+        if (text[pos] != '0' || integerDigits > 0)
+            integerDigits++;
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (text[pos] - '0');
+            if (mantissa != 0)
+                digits++;
+        }
+        else
+        {
+            exact = false;
+        }
+    }
+    if (pos < size && text[pos] == '.')
+    {
+        for (pos++; pos < size && IsDigit(text[pos]); pos++)
+        {
+            if (integerDigits == 0 && !nonZero)
+            {
+                if (text[pos] == '0')
+                    leadingZeros++;
+                else
+                    nonZero = true;
+            }
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (text[pos] - '0');
+                if (mantissa != 0)
+                    digits++;
+                exponent--;
+            }
+            else
+            {
+                exact = false;
+            }
+        }
+    }
+    int explicitExponent = 0;
+    if (pos < size && (text[pos] == 'e' || text[pos] == 'E'))
+    {
+        pos++;
+        bool negativeExponent = false;
+        if (pos < size && (text[pos] == '+' || text[pos] == '-'))
+            negativeExponent = text[pos++] == '-';
+
+        for (; pos < size && IsDigit(text[pos]); pos++)
+        {
+            if (explicitExponent < 10000)
+                explicitExponent = explicitExponent * 10 + (text[pos] - '0');
+        }
+        if (negativeExponent)
+            explicitExponent = -explicitExponent;
+        exponent += explicitExponent;
+    }
+    if (pos != size)
+        return false;
+
+    // Clinger's fast path: both the mantissa and the power of ten are exact
+    // doubles, so a single multiplication or division rounds correctly.
+    if (exact && mantissa <= kMaxExactMantissa && exponent >= -22 && exponent <= 22)
+    {
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / kPowersOfTen[-exponent] : result * kPowersOfTen[exponent];
+        value = negative ? -result : result;
+        return true;
+    }
+
+    std::from_chars_result parsed = std::from_chars(text.data(), text.data() + size, value);
+    if (parsed.ec == std::errc::result_out_of_range)
+    {
+        // from_chars leaves `value` alone here; round the way strtod does.
+        int order = (integerDigits > 0 ? integerDigits - 1 : -(leadingZeros + 1)) + explicitExponent;
+        double result = order > 0 ? HUGE_VAL : 0.0;
+        value = negative ? -result : result;
+        return true;
+    }
+    return parsed.ec == std::errc();
+}
+
+Number Number::FromLexeme(std::string_view text, std::pmr::memory_resource *resource)
+{
+    if (text.find_first_of(".eE") == std::string_view::npos)
+    {
+        // "-0" stays a lexeme: as an integer it would print as "0".
+        int64_t signedValue;
+        if (ParseInteger(text, signedValue) && !(signedValue == 0 && text[0] == '-'))
+            return Number(signedValue, resource);
+
+        uint64_t unsignedValue;
+        if (ParseInteger(text, unsignedValue))
+            return Number(unsignedValue, resource);
+    }
+
+    Number number(0.0, resource);
+    number.kind = KIND::LEXEME;
+    number.converted = false;
+    number.lexeme.assign(text.data(), text.size());
+    return number;
+}
+
+double Number::AsDouble()
+{
+    switch (kind)
+    {
+    case KIND::INT64:
+        return static_cast<double>(i);
+    case KIND::UINT64:
+        return static_cast<double>(u);
+    case KIND::DOUBLE:
+        return d;
+    case KIND::LEXEME:
+        if (!converted)
+        {
+            if (!ParseDouble(lexeme, d))
+                throw std::runtime_error("Invalid number: " + std::string(lexeme));
+            converted = true;
+        }
+        return d;
+    }
+    return 0;
+}
+
+int64_t Number::AsInt64()
+{
+    switch (kind)
+    {
+    case KIND::INT64:
+        return i;
+    case KIND::UINT64:
+        return static_cast<int64_t>(u);
+    default:
+        return static_cast<int64_t>(AsDouble());
+    }
+}
+
+uint64_t Number::AsUInt64()
+{
+    switch (kind)
+    {
+    case KIND::INT64:
+        return static_cast<uint64_t>(i);
+    case KIND::UINT64:
+        return u;
+    default:
+        return static_cast<uint64_t>(AsDouble());
+    }
+}
+
+void Number::Write(Writer &out) const
+{
+    char buffer[kMaxNumberChars];
+    switch (kind)
+    {
+    case KIND::INT64:
+        out.Write(std::string_view(buffer, FormatInteger(i, buffer)));
+        break;
+    case KIND::UINT64:
+        out.Write(std::string_view(buffer, FormatInteger(u, buffer)));
+        break;
+    case KIND::DOUBLE:
+        out.Write(std::string_view(buffer, FormatDouble(d, buffer)));
+        break;
+    case KIND::LEXEME:
+        out.Write(lexeme);
+        break;
+    }
+}
@@ -0,0 +1,38 @@
+#include "NumberFormat.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Largest magnitude below which every integer is exactly representable.
+    constexpr double kMaxExactInteger = 9007199254740992.0; // 2^53
+}
+
+size_t FormatInteger(int64_t value, char *out)
+{
+    return std::to_chars(out, out + kMaxNumberChars, value).ptr - out;
+}
+
+size_t FormatInteger(uint64_t value, char *out)
+{
+    return std::to_chars(out, out + kMaxNumberChars, value).ptr - out;
+}
+
+size_t FormatDouble(double value, char *out)
+{
+    if (!std::isfinite(value))
+    {
+        std::memcpy(out, "null", 4);
+        return 4;
+    }
+
+    if (value >= -kMaxExactInteger && value <= kMaxExactInteger)
+    {
+        int64_t integer = static_cast<int64_t>(value);
+        if (static_cast<double>(integer) == value)
+            return FormatInteger(integer, out);
+    }
+
+    return std::to_chars(out, out + kMaxNumberChars, value).ptr - out;
+}
@@ -2,27 +2,30 @@
 #include "Parser.hpp"
 #include "Tokenizer.hpp"
 #include "Json.hpp"
+#include "MappedFile.hpp"
+#include "TreeBuilder.hpp"
+#include "Transcoder.hpp"
 
 Json::Object *Parser::ParseJsonValue()
 {
-    TokenJson curToken = currentTokenJson();
+    const TokenJson &curToken = currentTokenJson();
 
     switch (curToken.type)
     {
     case TOKEN_TYPE::STRING:
-        return new Json::JsonString(curToken.value);
+        return Make<Json::JsonString>(curToken.value);
         break;
     case TOKEN_TYPE::NUMBER:
-        return new Json::JsonNumber(stod(curToken.value));
+        return Make<Json::JsonNumber>(curToken.value);
         break;
     case TOKEN_TYPE::TRUE:
-        return new Json::JsonBoolean(true);
+        return Make<Json::JsonBoolean>(true);
         break;
     case TOKEN_TYPE::FALSE:
-        return new Json::JsonBoolean(false);
+        return Make<Json::JsonBoolean>(false);
         break;
     case TOKEN_TYPE::NONE:
-        return new Json::JsonNull();
+        return Make<Json::JsonNull>();
         break;
     case TOKEN_TYPE::BRACE_OPEN:
         return ParseJsonObject();
@@ -35,171 +38,294 @@ Json::Object *Parser::ParseJsonValue()
 }
 Json::Object *Parser::ParseJsonObject()
 {
-    TokenJson token = nextTokenJson();
-    Json::JsonMap *jsonMap = new Json::JsonMap();
+    const TokenJson *token = &nextTokenJson();
+    Json::JsonMap *jsonMap = Make<Json::JsonMap>();
+    std::unique_ptr<Json::Object> owner(HeapOwner(jsonMap));
+    Stats::Enter();
 
-    while (token.type != TOKEN_TYPE::BRACE_CLOSE)
+    while (token->type != TOKEN_TYPE::BRACE_CLOSE)
     {
-        Json::Object *key = ParseJsonValue();
-        token = nextTokenJson();
-        if (token.type != TOKEN_TYPE::COLON)
+        if (token->type != TOKEN_TYPE::STRING)
+            throw std::runtime_error("Expected string key in object");
+        std::string_view key = token->value;
+        token = &nextTokenJson();
+        if (token->type != TOKEN_TYPE::COLON)
             throw std::runtime_error("Expected : in key-value pair");
-        token = nextTokenJson();
+        token = &nextTokenJson();
         Json::Object *value = ParseJsonValue();
-        jsonMap->AddElement(key, value);
+        Json::Object *replaced;
+        if (this->keys != nullptr)
+            replaced = jsonMap->AddSymbol(this->keys->Intern(key), value);
+        else
+            replaced = jsonMap->AddElement(key, value);
+        delete HeapOwner(replaced);
 
-        token = nextTokenJson();
-        if (token.type == TOKEN_TYPE::COMMA)
-            token = nextTokenJson();
+        token = &nextTokenJson();
+        if (token->type == TOKEN_TYPE::BRACE_CLOSE)
+            break;
+        if (token->type != TOKEN_TYPE::COMMA)
+            throw std::runtime_error("Expected , or closing bracket");
+        token = &nextTokenJson();
+        if (token->type != TOKEN_TYPE::STRING)
+            throw std::runtime_error("Expected string key in object");
     }
+    Stats::Leave();
+    owner.release();
     return jsonMap;
 }
 Json::Object *Parser::ParseJsonArray()
 {
-    TokenJson token = nextTokenJson();
-    Json::JsonArray *jsonArray = new Json::JsonArray();
+    const TokenJson *token = &nextTokenJson();
+    Json::JsonArray *jsonArray = Make<Json::JsonArray>();
+    std::unique_ptr<Json::Object> owner(HeapOwner(jsonArray));
+    Stats::Enter();
 
-    while (token.type != TOKEN_TYPE::BRACKET_CLOSE)
+    while (token->type != TOKEN_TYPE::BRACKET_CLOSE)
     {
         Json::Object *value = ParseJsonValue();
         jsonArray->AddElement(value);
 
-        token = nextTokenJson();
-        if (token.type == TOKEN_TYPE::COMMA)
-            token = nextTokenJson();
+        token = &nextTokenJson();
+        if (token->type == TOKEN_TYPE::BRACKET_CLOSE)
+            break;
+        if (token->type != TOKEN_TYPE::COMMA)
+            throw std::runtime_error("Expected , or closing bracket");
+        token = &nextTokenJson();
+        if (token->type == TOKEN_TYPE::BRACKET_CLOSE)
+            throw std::runtime_error("unexpected token");
     }
+    Stats::Leave();
+    owner.release();
     return jsonArray;
 }
 
-Xml::Object *Parser::ParseXmlValue()
+SymbolTable *Parser::SelectSymbols()
 {
-    TokenXml curToken = currentTokenXml();
-
-    switch (curToken.type)
-    {
-    case TOKEN_TYPE::STRING:
-        return new Xml::XmlString(curToken.value);
-        break;
-    case TOKEN_TYPE::NUMBER:
-        return new Xml::XmlNumber(stod(curToken.value));
-        break;
-    case TOKEN_TYPE::TRUE:
-        return new Xml::XmlBoolean(true);
-        break;
-    case TOKEN_TYPE::FALSE:
-        return new Xml::XmlBoolean(false);
-        break;
-    case TOKEN_TYPE::NONE:
-        return new Xml::XmlNull();
-        break;
-    case TOKEN_TYPE::TAG_OPEN:
-        
-        if(current == 0){
-            return ParseXmlObject();
-        }
-
-        TokenXml rootToken = XmlTokens[current - 1];
-        rootToken.type = TOKEN_TYPE::TAG_CLOSE;
-
-        TokenXml token = XmlTokens[current];
-        unsigned short index = 1;
-        while (!XmlTokens[index + current].isEqual(rootToken))
-        {
-            if (token.isEqual(XmlTokens[index + current]))
-            {
-                return ParseXmlArray();
-            }
-            index++;
-        }
-        return ParseXmlObject();
-        break;
-    }
-    throw std::runtime_error("unexpected token");
+    if (this->symbols != nullptr)
+        return this->symbols;
+    if (this->arena == nullptr)
+        return nullptr;
+    this->scratchSymbols.Reset(*this->arena);
+    return &this->scratchSymbols;
 }
-Xml::Object *Parser::ParseXmlObject()
+void Parser::Reset()
 {
-    TokenXml token = currentTokenXml();
-    Xml::XmlMap *map = new Xml::XmlMap();
-    Xml::XmlString *key;
-    Xml::Object *value;
+    this->lexer = nullptr;
+    this->arena = nullptr;
+    this->symbols = nullptr;
+    this->keys = nullptr;
+    this->xmlBuilder.Reset(nullptr, nullptr);
+    this->xmlReader.Reset();
+}
 
-    if (XmlTokens[current + 1].type == TOKEN_TYPE::TAG_OPEN)
+// XML is read in one pass: the tree builder groups repeated sibling names
+// into arrays as the elements close, so no lookahead over the tokens is needed.
+Xml::Object *Parser::ParseXmlInput(std::string_view XmlString)
+{
+    this->xmlBuilder.Reset(this->arena, SelectSymbols());
+    this->xmlReader.Reset();
+    try
     {
-        key = new Xml::XmlString(token.value);
-        token = nextTokenXml();
-        value = ParseXmlValue();
-        map->AddElement(key,value);
-        delete key;
+        ReadXml(XmlString, this->xmlReader);
     }
-    else if (XmlTokens[current + 1].type != TOKEN_TYPE::TAG_OPEN &&
-             XmlTokens[current + 1].type != TOKEN_TYPE::TAG_CLOSE)
+    catch (...)
     {
-        TokenXml rootToken = XmlTokens[current - 1];
-        rootToken.type = TOKEN_TYPE::TAG_CLOSE;
-        while (!XmlTokens[current].isEqual(rootToken))
-        {
-            key = new Xml::XmlString(token.value);
-            token = nextTokenXml();
-            value = ParseXmlValue();
-            token = nextTokenXml();
-            token = nextTokenXml();
-            map->AddElement(key,value);
-        }
-        token = nextTokenXml();
+        this->xmlBuilder.Discard();
+        throw;
     }
-    return map;
+    return this->xmlBuilder.Root();
 }
-Xml::Object *Parser::ParseXmlArray()
+Xml::Object *Parser::ParseXml(std::string_view XmlString)
 {
-    Xml::XmlArray *arr = new Xml::XmlArray();
-    Xml::XmlMap * map = new Xml::XmlMap();
-
-    TokenXml rootToken = XmlTokens[current-1];
-    rootToken.type = TOKEN_TYPE::TAG_CLOSE;
-
-    Xml::XmlString* key = new Xml::XmlString(currentTokenXml().value);
-
-    while (!rootToken.isEqual(XmlTokens[current]))
-    {
-        current++;
-        Xml::Object *value = ParseXmlValue();
-        arr->AddElement(value);
-    }
-    map->AddElement(key, arr);
-    return map;
+    this->arena = nullptr;
+    return ParseXmlInput(XmlString);
 }
-
-Xml::Object *Parser::ParseXml(std::string &XmlString)
+Xml::Object *Parser::ParseXml(std::string_view XmlString, Arena &arena)
 {
-    this->current = 0;
-    Tokenizer tk;
-    this->XmlTokens = tk.TokenizeXml(XmlString);
-
-    return ParseXmlValue();
+    this->arena = &arena;
+    return ParseXmlInput(XmlString);
+}
+Xml::Document Parser::ParseXmlDocument(std::string_view XmlString)
+{
+    Xml::Document document;
+    document.SetRoot(ParseXml(XmlString, document.GetArena()));
+    return document;
+}
+void Parser::ParseXmlDocument(std::string_view XmlString, Xml::Document &document)
+{
+    document.Reset();
+    document.SetRoot(ParseXml(XmlString, document.GetArena()));
+}
+Xml::Document Parser::ParseXmlFile(const std::string &path)
+{
+    MappedFile file(path);
+    Xml::Document document;
+    this->arena = &document.GetArena();
+    document.SetRoot(ParseXmlInput(file.View()));
+    return document;
+}
+void Parser::ReadXml(std::string_view XmlString, Xml::Reader &reader)
+{
+    Stats::Operation operation(Stats::PHASE::PARSE);
+    Stats::CountBytesParsed(XmlString.size());
+    XmlLexer xmlLexer(XmlString);
+    TokenXml token;
+    while (xmlLexer.NextToken(token))
+        reader.OnToken(token);
+    if (!reader.Done())
+        throw std::runtime_error("Unexpected end of input");
+}
+void Parser::ParseXml(std::string_view XmlString, Xml::Handler &handler)
+{
+    Xml::Reader reader(handler);
+    ReadXml(XmlString, reader);
 }
 std::string Parser::UnParseXml(Xml::Object &object)
 {
     return object.toXmlString();
 }
-Json::Object *Parser::ParseJson(std::string &jsonString)
+void Parser::UnParseXml(Xml::Object &object, Writer &out)
+{
+    Stats::Operation operation(Stats::PHASE::SERIALIZE);
+    size_t written = out.Written();
+    object.writeXml(out);
+    Stats::CountBytesEmitted(out.Written() - written);
+}
+Json::Object *Parser::ParseJsonInput(std::string_view jsonString)
+{
+    Stats::Operation operation(Stats::PHASE::PARSE);
+    Stats::CountBytesParsed(jsonString.size());
+    JsonLexer jsonLexer(jsonString);
+    this->lexer = &jsonLexer;
+    if (!jsonLexer.NextToken(this->JsonToken))
+        throw std::runtime_error("Empty input");
+
+    this->keys = SelectSymbols();
+    Json::Object *root = ParseJsonValue();
+    std::unique_ptr<Json::Object> owner(HeapOwner(root));
+    if (jsonLexer.NextToken(this->JsonToken))
+        throw std::runtime_error("Unexpected data after document");
+    this->lexer = nullptr;
+    this->keys = nullptr;
+    owner.release();
+    return root;
+}
+Json::Object *Parser::ParseJson(std::string_view jsonString)
+{
+    this->arena = nullptr;
+    return ParseJsonInput(jsonString);
+}
+Json::Object *Parser::ParseJson(std::string_view jsonString, Arena &arena)
+{
+    this->arena = &arena;
+    return ParseJsonInput(jsonString);
+}
+Json::Document Parser::ParseJsonDocument(std::string_view jsonString)
+{
+    Json::Document document;
+    document.SetRoot(ParseJson(jsonString, document.GetArena()));
+    return document;
+}
+void Parser::ParseJsonDocument(std::string_view jsonString, Json::Document &document)
+{
+    document.Reset();
+    document.SetRoot(ParseJson(jsonString, document.GetArena()));
+}
+Json::Document Parser::ParseJsonFile(const std::string &path)
+{
+    MappedFile file(path);
+    Json::Document document;
+    this->arena = &document.GetArena();
+    document.SetRoot(ParseJsonInput(file.View()));
+    return document;
+}
+void Parser::ParseJson(std::string_view jsonString, Json::Handler &handler)
 {
-    this->current = 0;
-    Tokenizer tk;
-    this->JsonTokens = tk.TokenizeJson(jsonString);
-    return ParseJsonValue();
+    Stats::Operation operation(Stats::PHASE::PARSE);
+    Stats::CountBytesParsed(jsonString.size());
+    JsonLexer jsonLexer(jsonString);
+    Json::Reader reader(handler);
+    TokenJson token;
+    while (jsonLexer.NextToken(token))
+        reader.OnToken(token);
+    if (!reader.Done())
+        throw std::runtime_error("Unexpected end of input");
+}
+Json::Tape Parser::ParseJsonTape(std::string_view jsonString)
+{
+    Json::Tape tape;
+    Json::TapeBuilder builder(tape);
+    ParseJson(jsonString, builder);
+    return tape;
+}
+Json::LazyDocument Parser::ParseJsonLazy(std::string_view jsonString)
+{
+    return Json::LazyDocument(jsonString);
 }
 std::string Parser::UnParseJson(Json::Object &object)
 {
     return object.toJsonString();
 }
+void Parser::UnParseJson(Json::Object &object, Writer &out)
+{
+    Stats::Operation operation(Stats::PHASE::SERIALIZE);
+    size_t written = out.Written();
+    object.writeJson(out);
+    Stats::CountBytesEmitted(out.Written() - written);
+}
 
-std::string Parser::JsonToXml(std::string &jsonString)
+// Conversions stream reader events straight into the output format, no
+// tree is built.
+std::string Parser::JsonToXml(std::string_view jsonString)
+{
+    std::string result;
+    Writer out(result);
+    JsonToXml(jsonString, out);
+    return result;
+}
+std::string Parser::XmlToJson(std::string_view XmlString)
+{
+    std::string result;
+    Writer out(result);
+    XmlToJson(XmlString, out);
+    return result;
+}
+void Parser::JsonToXml(std::string_view jsonString, Writer &out)
 {
-    Json::Object *obj = this->ParseJson(jsonString);
-    return obj->toXmlString();
+    Stats::Operation operation(Stats::PHASE::PARSE);
+    size_t written = out.Written();
+    Json::XmlTranscoder transcoder(out);
+    ParseJson(jsonString, transcoder);
+    Stats::CountBytesEmitted(out.Written() - written);
 }
-std::string Parser::XmlToJson(std::string &XmlString)
+// The output is held until the end, so that a document the transcoder
+// cannot group can be converted again through the tree.
+void Parser::XmlToJson(std::string_view XmlString, Writer &out)
 {
-    Xml::Object *obj = this->ParseXml(XmlString);
-    return obj->toJsonString();
+    Stats::Operation operation(Stats::PHASE::PARSE);
+    size_t written = out.Written();
+    unsigned int depth = out.Depth();
+    out.Hold(written);
+    try
+    {
+        try
+        {
+            Xml::JsonTranscoder transcoder(out);
+            ParseXml(XmlString, transcoder);
+        }
+        catch (const Xml::NonAdjacentRepeat &)
+        {
+            out.Rewind(written, depth);
+            Xml::Document document;
+            document.SetRoot(ParseXml(XmlString, document.GetArena()));
+            document.Root()->writeJson(out);
+        }
+    }
+    catch (...)
+    {
+        out.Release();
+        throw;
+    }
+    out.Release();
+    Stats::CountBytesEmitted(out.Written() - written);
 }
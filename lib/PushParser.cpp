@@ -0,0 +1,138 @@
+#include "PushParser.hpp"
+#include <stdexcept>
+#include "Stats.hpp"
+
+namespace
+{
+    // Characters that can complete a token which starts with `first`.
+    const char *JsonDelimiters(char first)
+    {
+        return first == '"' ? "\"" : " \t\r\n,:[]{}\"";
+    }
+
+    const char *XmlDelimiters(char first)
+    {
+        if (first == '<')
+            return ">";
+        if (first == '"')
+            return "\"";
+        return "<";
+    }
+
+    // Completes the token held in `pending` with bytes from `chunk`, handing
+    // back whatever the lexer did not need. Returns the offset in `chunk`
+    // where regular processing resumes, or chunk.size() if the token is still
+    // incomplete.
+    template <typename DrainFn>
+    size_t CompletePending(std::string &pending, std::string_view chunk, const char *delimiters, DrainFn drain)
+    {
+        size_t pos = 0;
+        while (pos < chunk.size())
+        {
+            size_t cut = chunk.find_first_of(delimiters, pos);
+            size_t take = (cut == std::string_view::npos ? chunk.size() : cut + 1) - pos;
+            pending.append(chunk.data() + pos, take);
+            pos += take;
+
+            size_t rest = pending.size() - drain(pending);
+            if (rest <= take)
+            {
+                pending.clear();
+                return pos - rest;
+            }
+        }
+        return chunk.size();
+    }
+}
+
+size_t JsonPushReader::Drain(std::string_view input, bool final)
+{
+    JsonLexer lexer(input, final);
+    TokenJson token;
+    while (lexer.NextToken(token))
+        reader.OnToken(token);
+    return lexer.Position();
+}
+
+void JsonPushReader::feed(std::string_view chunk)
+{
+    Stats::Operation operation(Stats::PHASE::PARSE);
+    Stats::CountBytesParsed(chunk.size());
+    size_t pos = 0;
+    if (!pending.empty())
+    {
+        pos = CompletePending(pending, chunk, JsonDelimiters(pending[0]),
+                              [this](std::string_view input)
+                              { return Drain(input, false); });
+        if (!pending.empty())
+            return;
+    }
+
+    std::string_view rest = chunk.substr(pos);
+    pending.assign(rest.substr(Drain(rest, false)));
+}
+
+void JsonPushReader::finish()
+{
+    Stats::Operation operation(Stats::PHASE::PARSE);
+    if (!pending.empty())
+    {
+        Drain(pending, true);
+        pending.clear();
+    }
+    if (!reader.Done())
+        throw std::runtime_error("Unexpected end of input");
+}
+
+size_t XmlPushReader::Drain(std::string_view input, bool final)
+{
+    XmlLexer lexer(input, final);
+    TokenXml token;
+    while (lexer.NextToken(token))
+        reader.OnToken(token);
+    return lexer.Position();
+}
+
+void XmlPushReader::feed(std::string_view chunk)
+{
+    Stats::Operation operation(Stats::PHASE::PARSE);
+    Stats::CountBytesParsed(chunk.size());
+    size_t pos = 0;
+    if (!pending.empty())
+    {
+        pos = CompletePending(pending, chunk, XmlDelimiters(pending[0]),
+                              [this](std::string_view input)
+                              { return Drain(input, false); });
+        if (!pending.empty())
+            return;
+    }
+
+    std::string_view rest = chunk.substr(pos);
+    pending.assign(rest.substr(Drain(rest, false)));
+}
+
+void XmlPushReader::finish()
+{
+    Stats::Operation operation(Stats::PHASE::PARSE);
+    if (!pending.empty())
+    {
+        Drain(pending, true);
+        pending.clear();
+    }
+    if (!reader.Done())
+        throw std::runtime_error("Unexpected end of input");
+}
+
+Json::Document JsonPushParser::finish()
+{
+    reader.finish();
+    document.SetRoot(builder.Root());
+    return std::move(document);
+}
+
+Xml::Document XmlPushParser::finish()
+{
+    reader.finish();
+    document.SetRoot(builder.Root());
+    return std::move(document);
+}
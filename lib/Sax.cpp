@@ -0,0 +1,155 @@
+#include "Sax.hpp"
+#include <stdexcept>
+#include "Stats.hpp"
+
+namespace Json
+{
+    void Reader::Close(TOKEN_TYPE type)
+    {
+        bool isObject = type == TOKEN_TYPE::BRACE_CLOSE;
+        if (stack.empty() || stack.back() != isObject)
+            throw std::runtime_error("Mismatched closing bracket");
+
+        stack.pop_back();
+        if (isObject)
+            handler.onEndObject();
+        else
+            handler.onEndArray();
+        ValueDone();
+    }
+
+    void Reader::OnToken(const TokenJson &token)
+    {
+        switch (state)
+        {
+        case STATE::VALUE_OR_END:
+            if (token.type == TOKEN_TYPE::BRACKET_CLOSE)
+            {
+                Close(token.type);
+                return;
+            }
+            [[fallthrough]];
+        case STATE::VALUE:
+            switch (token.type)
+            {
+            case TOKEN_TYPE::STRING:
+                handler.onString(token.value);
+                ValueDone();
+                return;
+            case TOKEN_TYPE::NUMBER:
+                handler.onNumber(token.value);
+                ValueDone();
+                return;
+            case TOKEN_TYPE::TRUE:
+                handler.onBoolean(true);
+                ValueDone();
+                return;
+            case TOKEN_TYPE::FALSE:
+                handler.onBoolean(false);
+                ValueDone();
+                return;
+            case TOKEN_TYPE::NONE:
+                handler.onNull();
+                ValueDone();
+                return;
+            case TOKEN_TYPE::BRACE_OPEN:
+                stack.push_back(true);
+                Stats::Depth(stack.size());
+                handler.onStartObject();
+                state = STATE::KEY_OR_END;
+                return;
+            case TOKEN_TYPE::BRACKET_OPEN:
+                stack.push_back(false);
+                Stats::Depth(stack.size());
+                handler.onStartArray();
+                state = STATE::VALUE_OR_END;
+                return;
+            default:
+                throw std::runtime_error("unexpected token");
+            }
+        case STATE::KEY_OR_END:
+            if (token.type == TOKEN_TYPE::BRACE_CLOSE)
+            {
+                Close(token.type);
+                return;
+            }
+            [[fallthrough]];
+        case STATE::KEY:
+            if (token.type != TOKEN_TYPE::STRING)
+                throw std::runtime_error("Expected string key in object");
+            handler.onKey(token.value);
+            state = STATE::COLON;
+            return;
+        case STATE::COLON:
+            if (token.type != TOKEN_TYPE::COLON)
+                throw std::runtime_error("Expected : in key-value pair");
+            state = STATE::VALUE;
+            return;
+        case STATE::COMMA_OR_END:
+            if (token.type == TOKEN_TYPE::COMMA)
+            {
+                state = stack.back() ? STATE::KEY : STATE::VALUE;
+                return;
+            }
+            if (token.type == TOKEN_TYPE::BRACE_CLOSE || token.type == TOKEN_TYPE::BRACKET_CLOSE)
+            {
+                Close(token.type);
+                return;
+            }
+            throw std::runtime_error("Expected , or closing bracket");
+        case STATE::DONE:
+            throw std::runtime_error("Unexpected data after document");
+        }
+    }
+} // namespace Json
+
+namespace Xml
+{
+    void Reader::OnToken(const TokenXml &token)
+    {
+        if (done)
+            throw std::runtime_error("Unexpected data after document");
+
+        switch (token.type)
+        {
+        case TOKEN_TYPE::TAG_OPEN:
+            if (depth == stack.size())
+                stack.emplace_back();
+            stack[depth++].assign(token.value);
+            Stats::Depth(depth);
+            handler.onStartElement(token.value, token.attributes);
+            return;
+        case TOKEN_TYPE::TAG_CLOSE:
+            if (depth == 0 || stack[depth - 1] != token.value)
+                throw std::runtime_error("Mismatched closing tag: " + std::string(token.value));
+            depth--;
+            handler.onEndElement(token.value);
+            done = depth == 0;
+            return;
+        default:
+            break;
+        }
+
+        if (depth == 0)
+            throw std::runtime_error("Text outside of the root element");
+
+        switch (token.type)
+        {
+        case TOKEN_TYPE::NUMBER:
+            handler.onNumber(token.value);
+            break;
+        case TOKEN_TYPE::TRUE:
+            handler.onBoolean(true);
+            break;
+        case TOKEN_TYPE::FALSE:
+            handler.onBoolean(false);
+            break;
+        case TOKEN_TYPE::NONE:
+            handler.onNull();
+            break;
+        default:
+            handler.onString(token.value);
+            break;
+        }
+    }
+} // namespace Xml
@@ -0,0 +1,326 @@
+#include "Simd.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JSONXML_X86 1
+#endif
+
+namespace
+{
+    using ClassifyFn = void (*)(const char *, Simd::BlockMasks &);
+    using ScanFn = size_t (*)(const char *, size_t, size_t);
+
+    inline bool IsQuoteOrBackslash(char c)
+    {
+        return c == '"' || c == '\\';
+    }
+
+    size_t SkipWhitespaceScalar(const char *data, size_t pos, size_t size)
+    {
+        while (pos < size && Simd::IsWhitespace(data[pos]))
+            pos++;
+        return pos;
+    }
+
+    size_t FindQuoteOrBackslashScalar(const char *data, size_t pos, size_t size)
+    {
+        while (pos < size && !IsQuoteOrBackslash(data[pos]))
+            pos++;
+        return pos;
+    }
+
+    void ClassifyScalar(const char *data, Simd::BlockMasks &masks)
+    {
+        masks = Simd::BlockMasks{0, 0, 0, 0};
+        for (size_t i = 0; i < Simd::kBlockSize; i++)
+        {
+            uint64_t bit = uint64_t(1) << i;
+            switch (data[i])
+            {
+            case '"':
+                masks.quote |= bit;
+                break;
+            case '\\':
+                masks.backslash |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                masks.structural |= bit;
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                masks.whitespace |= bit;
+                break;
+            }
+        }
+    }
+
+#ifdef JSONXML_X86
+    __attribute__((target("avx2"))) inline uint32_t Match32(__m256i chunk, char c)
+    {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c))));
+    }
+
+    __attribute__((target("avx2"))) inline uint64_t Match64(__m256i lo, __m256i hi, char c)
+    {
+        return uint64_t(Match32(lo, c)) | (uint64_t(Match32(hi, c)) << 32);
+    }
+
+    __attribute__((target("avx2"))) void ClassifyAvx2(const char *data, Simd::BlockMasks &masks)
+    {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 32));
+
+        masks.quote = Match64(lo, hi, '"');
+        masks.backslash = Match64(lo, hi, '\\');
+        masks.structural = Match64(lo, hi, '{') | Match64(lo, hi, '}') |
+                           Match64(lo, hi, '[') | Match64(lo, hi, ']') |
+                           Match64(lo, hi, ':') | Match64(lo, hi, ',');
+        masks.whitespace = Match64(lo, hi, ' ') | Match64(lo, hi, '\t') |
+                           Match64(lo, hi, '\n') | Match64(lo, hi, '\r');
+    }
+
+    // Scanners compare only the bytes they look for, 32 or 16 at a time,
+    // and finish the last partial chunk with the scalar loop.
+    __attribute__((target("avx2"))) size_t SkipWhitespaceAvx2(const char *data, size_t pos, size_t size)
+    {
+        for (; pos + 32 <= size; pos += 32)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+            uint32_t space = Match32(chunk, ' ') | Match32(chunk, '\t') | Match32(chunk, '\n') | Match32(chunk, '\r');
+            if (space != 0xFFFFFFFFu)
+                return pos + __builtin_ctz(~space);
+        }
+        return SkipWhitespaceScalar(data, pos, size);
+    }
+
+    __attribute__((target("avx2"))) size_t FindQuoteOrBackslashAvx2(const char *data, size_t pos, size_t size)
+    {
+        for (; pos + 32 <= size; pos += 32)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+            uint32_t hits = Match32(chunk, '"') | Match32(chunk, '\\');
+            if (hits != 0)
+                return pos + __builtin_ctz(hits);
+        }
+        return FindQuoteOrBackslashScalar(data, pos, size);
+    }
+
+    __attribute__((target("sse2"))) inline uint32_t Match16(__m128i chunk, char c)
+    {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(c))));
+    }
+
+    __attribute__((target("sse2"))) size_t SkipWhitespaceSse2(const char *data, size_t pos, size_t size)
+    {
+        for (; pos + 16 <= size; pos += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+            uint32_t space = Match16(chunk, ' ') | Match16(chunk, '\t') | Match16(chunk, '\n') | Match16(chunk, '\r');
+            if (space != 0xFFFFu)
+                return pos + __builtin_ctz(~space);
+        }
+        return SkipWhitespaceScalar(data, pos, size);
+    }
+
+    __attribute__((target("sse2"))) size_t FindQuoteOrBackslashSse2(const char *data, size_t pos, size_t size)
+    {
+        for (; pos + 16 <= size; pos += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+            uint32_t hits = Match16(chunk, '"') | Match16(chunk, '\\');
+            if (hits != 0)
+                return pos + __builtin_ctz(hits);
+        }
+        return FindQuoteOrBackslashScalar(data, pos, size);
+    }
+
+    // SSE4.2 string compare: each call reports which of 16 bytes equal any
+    // byte of the needle set.
+    __attribute__((target("sse4.2"))) inline uint64_t MatchAny16(__m128i chunk, __m128i set, int setSize)
+    {
+        __m128i mask = _mm_cmpestrm(set, setSize, chunk, 16,
+                                    _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+        return static_cast<uint64_t>(_mm_cvtsi128_si32(mask)) & 0xFFFF;
+    }
+
+    __attribute__((target("sse4.2"))) void ClassifySse42(const char *data, Simd::BlockMasks &masks)
+    {
+        const __m128i quote = _mm_setr_epi8('"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i backslash = _mm_setr_epi8('\\', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i structural = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i whitespace = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+        masks = Simd::BlockMasks{0, 0, 0, 0};
+        for (int i = 0; i < 4; i++)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * 16));
+            int shift = i * 16;
+            masks.quote |= MatchAny16(chunk, quote, 1) << shift;
+            masks.backslash |= MatchAny16(chunk, backslash, 1) << shift;
+            masks.structural |= MatchAny16(chunk, structural, 6) << shift;
+            masks.whitespace |= MatchAny16(chunk, whitespace, 4) << shift;
+        }
+    }
+#endif
+
+    struct Kernel
+    {
+        ClassifyFn classify;
+        ScanFn skipWhitespace;
+        ScanFn findQuoteOrBackslash;
+        const char *name;
+    };
+
+    // Fills `kernel` if this CPU can run the one called `name`.
+    bool FindKernel(const char *name, Kernel &kernel)
+    {
+#ifdef JSONXML_X86
+        __builtin_cpu_init();
+        if (std::strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2"))
+        {
+            kernel = {ClassifyAvx2, SkipWhitespaceAvx2, FindQuoteOrBackslashAvx2, "avx2"};
+            return true;
+        }
+        if (std::strcmp(name, "sse4.2") == 0 && __builtin_cpu_supports("sse4.2"))
+        {
+            kernel = {ClassifySse42, SkipWhitespaceSse2, FindQuoteOrBackslashSse2, "sse4.2"};
+            return true;
+        }
+#endif
+        if (std::strcmp(name, "scalar") == 0)
+        {
+            kernel = {ClassifyScalar, SkipWhitespaceScalar, FindQuoteOrBackslashScalar, "scalar"};
+            return true;
+        }
+        return false;
+    }
+
+    Kernel SelectKernel()
+    {
+        Kernel kernel;
+        if (!FindKernel("avx2", kernel) && !FindKernel("sse4.2", kernel))
+            FindKernel("scalar", kernel);
+        return kernel;
+    }
+
+    Kernel &ActiveKernel()
+    {
+        static Kernel kernel = SelectKernel();
+        return kernel;
+    }
+
+    inline uint64_t LowBits(size_t count)
+    {
+        return count >= 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+    }
+}
+
+namespace Simd
+{
+    void Classify(const char *data, size_t size, BlockMasks &masks)
+    {
+        if (size >= kBlockSize)
+        {
+            ActiveKernel().classify(data, masks);
+            return;
+        }
+
+        // Zero bytes match none of the classes, so padding is neutral.
+        char block[kBlockSize] = {};
+        std::memcpy(block, data, size);
+        ActiveKernel().classify(block, masks);
+
+        uint64_t valid = LowBits(size);
+        masks.quote &= valid;
+        masks.backslash &= valid;
+        masks.structural &= valid;
+        masks.whitespace &= valid;
+    }
+
+    size_t FindQuoteOrBackslashLong(const char *data, size_t pos, size_t size)
+    {
+        return ActiveKernel().findQuoteOrBackslash(data, pos, size);
+    }
+
+    size_t SkipWhitespaceLong(const char *data, size_t pos, size_t size)
+    {
+        return ActiveKernel().skipWhitespace(data, pos, size);
+    }
+
+    size_t MatchClose(const char *data, size_t open, size_t size)
+    {
+        StringScanner strings;
+        BlockMasks masks;
+        size_t depth = 0;
+        for (size_t block = open; block < size; block += kBlockSize)
+        {
+            size_t length = size - block < kBlockSize ? size - block : kBlockSize;
+            Classify(data + block, length, masks);
+            uint64_t structural = masks.structural & ~strings.Next(masks);
+            while (structural != 0)
+            {
+                size_t pos = block + __builtin_ctzll(structural);
+                structural &= structural - 1;
+                char c = data[pos];
+                if (c == '{' || c == '[')
+                    depth++;
+                else if ((c == '}' || c == ']') && --depth == 0)
+                    return pos;
+            }
+        }
+        return size;
+    }
+
+    // Escaped bytes are found with the carry trick from simdjson: adding a
+    // backslash run to the odd bit positions leaves a bit set just past every
+    // run of odd length.
+    uint64_t StringScanner::Next(const BlockMasks &masks)
+    {
+        constexpr uint64_t kOddBits = 0xAAAAAAAAAAAAAAAAull;
+
+        uint64_t escaped = nextEscaped;
+        if (masks.backslash != 0)
+        {
+            uint64_t potential = masks.backslash & ~nextEscaped;
+            uint64_t maybeEscaped = potential << 1;
+            uint64_t code = ((maybeEscaped | kOddBits) - potential) ^ kOddBits;
+            escaped = code ^ (masks.backslash | nextEscaped);
+            nextEscaped = (code & masks.backslash) >> 63;
+        }
+        else
+        {
+            nextEscaped = 0;
+        }
+
+        // Prefix XOR of the real quotes toggles at each one.
+        uint64_t inside = masks.quote & ~escaped;
+        inside ^= inside << 1;
+        inside ^= inside << 2;
+        inside ^= inside << 4;
+        inside ^= inside << 8;
+        inside ^= inside << 16;
+        inside ^= inside << 32;
+        inside ^= inString;
+
+        inString = static_cast<uint64_t>(static_cast<int64_t>(inside) >> 63);
+        return inside;
+    }
+
+    const char *KernelName()
+    {
+        return ActiveKernel().name;
+    }
+
+    bool UseKernel(const char *name)
+    {
+        return FindKernel(name, ActiveKernel());
+    }
+} // namespace Simd
@@ -0,0 +1,102 @@
+#include "Stats.hpp"
+#include <chrono>
+#include <utility>
+
+namespace
+{
+    Stats::Callback callback;
+}
+
+namespace Stats
+{
+    uint64_t Counters::Tokens() const
+    {
+        uint64_t total = 0;
+        for (uint64_t count : tokens)
+            total += count;
+        return total;
+    }
+
+    void Counters::Add(const Counters &other)
+    {
+        for (size_t i = 0; i < kPhases; i++)
+            nanoseconds[i] += other.nanoseconds[i];
+        bytesParsed += other.bytesParsed;
+        bytesEmitted += other.bytesEmitted;
+        for (size_t i = 0; i < kTokenTypes; i++)
+            tokens[i] += other.tokens[i];
+        nodes += other.nodes;
+        if (other.maxDepth > maxDepth)
+            maxDepth = other.maxDepth;
+    }
+
+    void SetCallback(Callback hook)
+    {
+        callback = std::move(hook);
+    }
+
+    const Counters &Totals()
+    {
+        return Detail::Local().totals;
+    }
+
+    void ResetTotals()
+    {
+        Detail::Local().totals = Counters();
+    }
+
+    namespace Detail
+    {
+        State &Local()
+        {
+            thread_local State state;
+            return state;
+        }
+
+        uint64_t Now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        // Smallest of a few back-to-back readings, so a preemption during
+        // calibration does not inflate it.
+        uint64_t ClockOverhead()
+        {
+            static const uint64_t overhead = []
+            {
+                uint64_t best = UINT64_MAX;
+                for (int i = 0; i < 1000; i++)
+                {
+                    uint64_t start = Now();
+                    uint64_t elapsed = Now() - start;
+                    if (elapsed < best)
+                        best = elapsed;
+                }
+                return best;
+            }();
+            return overhead;
+        }
+
+        void BeginOperation()
+        {
+            State &state = Local();
+            if (state.operations++ == 0)
+            {
+                state.current = Counters();
+                state.depth = 0;
+            }
+        }
+
+        void EndOperation()
+        {
+            State &state = Local();
+            if (--state.operations != 0)
+                return;
+            state.totals.Add(state.current);
+            if (callback)
+                callback(state.current);
+        }
+    } // namespace Detail
+} // namespace Stats
@@ -0,0 +1,75 @@
+#include "SymbolTable.hpp"
+#include <cstring>
+#include <functional>
+
+namespace
+{
+    constexpr size_t kInitialSlots = 64;
+
+    inline size_t Hash(std::string_view text)
+    {
+        return std::hash<std::string_view>()(text);
+    }
+}
+
+SymbolTable::SymbolTable() : owned(std::make_unique<Arena>()), storage(owned.get()), count(0)
+{
+}
+
+SymbolTable::SymbolTable(Arena &storage) : storage(&storage), count(0)
+{
+}
+
+// Keeps the table at most half full.
+void SymbolTable::Grow()
+{
+    std::vector<std::string_view> old(slots.empty() ? kInitialSlots : 2 * slots.size());
+    old.swap(slots);
+
+    size_t mask = slots.size() - 1;
+    for (std::string_view symbol : old)
+    {
+        if (symbol.data() == nullptr)
+            continue;
+        size_t slot = Hash(symbol) & mask;
+        while (slots[slot].data() != nullptr)
+            slot = (slot + 1) & mask;
+        slots[slot] = symbol;
+    }
+}
+
+std::string_view SymbolTable::Intern(std::string_view text)
+{
+    if (2 * (count + 1) > slots.size())
+        Grow();
+
+    size_t mask = slots.size() - 1;
+    size_t slot = Hash(text) & mask;
+    while (slots[slot].data() != nullptr)
+    {
+        if (slots[slot] == text)
+            return slots[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    char *copy = static_cast<char *>(storage->allocate(text.size() + 1, 1));
+    std::memcpy(copy, text.data(), text.size());
+    copy[text.size()] = '\0';
+    slots[slot] = std::string_view(copy, text.size());
+    count++;
+    return slots[slot];
+}
+
+void SymbolTable::Clear()
+{
+    std::fill(slots.begin(), slots.end(), std::string_view());
+    count = 0;
+    if (owned)
+        owned->Release();
+}
+
+void SymbolTable::Reset(Arena &storage)
+{
+    Clear();
+    this->storage = &storage;
+}
@@ -0,0 +1,360 @@
+#include "Tape.hpp"
+#include <cstring>
+#include <stdexcept>
+#include "Number.hpp"
+
+namespace Json
+{
+    uint64_t Tape::AppendString(std::string_view text)
+    {
+        uint64_t offset = strings.size();
+        uint32_t length = static_cast<uint32_t>(text.size());
+        strings.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        strings.append(text.data(), text.size());
+        return offset;
+    }
+
+    std::string_view Tape::String(size_t index) const
+    {
+        size_t offset = Payload(index);
+        uint32_t length;
+        std::memcpy(&length, strings.data() + offset, sizeof(length));
+        return std::string_view(strings.data() + offset + sizeof(length), length);
+    }
+
+    TapeRef Tape::Root() const
+    {
+        return entries.empty() ? TapeRef() : TapeRef(this, 0);
+    }
+
+    void Tape::Clear()
+    {
+        entries.clear();
+        strings.clear();
+        numbers.clear();
+        items.clear();
+    }
+
+    // Same layout as Object::writeJson.
+    void Tape::WriteJson(Writer &out, size_t index) const
+    {
+        char tag = Tag(index);
+        switch (tag)
+        {
+        case '{':
+        case '[':
+        {
+            bool isObject = tag == '{';
+            size_t end = Payload(index);
+            out.Write(tag);
+            out.Indent();
+            for (size_t i = index + 1; i < end;)
+            {
+                if (i > index + 1)
+                    out.Write(',');
+                out.Break();
+                if (isObject)
+                {
+                    out.Write('"');
+                    out.Write(String(i));
+                    out.Write(out.IsPretty() ? "\": " : "\":");
+                    i++;
+                }
+                WriteJson(out, i);
+                i = Skip(i);
+            }
+            out.Dedent();
+            if (end > index + 1)
+                out.Break();
+            out.Write(isObject ? '}' : ']');
+            break;
+        }
+        case '"':
+            out.Write('"');
+            out.Write(String(index));
+            out.Write('"');
+            break;
+        case 'n':
+            out.Write(String(index));
+            break;
+        case 'l':
+        {
+            char buffer[kMaxNumberChars];
+            int64_t value = static_cast<int64_t>(numbers[Payload(index)]);
+            out.Write(std::string_view(buffer, FormatInteger(value, buffer)));
+            break;
+        }
+        case 'u':
+        {
+            char buffer[kMaxNumberChars];
+            out.Write(std::string_view(buffer, FormatInteger(numbers[Payload(index)], buffer)));
+            break;
+        }
+        case 't':
+            out.Write("true");
+            break;
+        case 'f':
+            out.Write("false");
+            break;
+        default:
+            out.Write("null");
+            break;
+        }
+    }
+
+    void Tape::writeJson(Writer &out) const
+    {
+        if (!entries.empty())
+            WriteJson(out, 0);
+    }
+
+    std::string Tape::toJsonString() const
+    {
+        std::string result;
+        Writer out(result);
+        writeJson(out);
+        return result;
+    }
+
+    OBJECT_TYPE TapeRef::getType() const
+    {
+        if (tape == nullptr)
+            throw std::runtime_error("Invalid ref");
+        switch (tape->Tag(index))
+        {
+        case '{':
+            return OBJECT_TYPE::MAP;
+        case '[':
+            return OBJECT_TYPE::ARRAY;
+        case '"':
+            return OBJECT_TYPE::STRING;
+        case 't':
+        case 'f':
+            return OBJECT_TYPE::BOOLEAN;
+        case '0':
+            return OBJECT_TYPE::NONE;
+        default:
+            return OBJECT_TYPE::NUMERIC;
+        }
+    }
+
+    size_t TapeRef::Size() const
+    {
+        if (tape == nullptr)
+            throw std::runtime_error("Invalid ref");
+        char tag = tape->Tag(index);
+        if (tag == '[')
+            return tape->items[tape->Payload(tape->Payload(index))];
+        if (tag == '{')
+            return tape->Payload(tape->Payload(index));
+        return 0;
+    }
+
+    TapeRef TapeRef::operator[](size_t position) const
+    {
+        if (tape == nullptr)
+            return TapeRef();
+        if (tape->Tag(index) != '[')
+            throw std::runtime_error("Not an array");
+
+        size_t offset = tape->Payload(tape->Payload(index));
+        if (position >= tape->items[offset])
+            return TapeRef();
+        return TapeRef(tape, tape->items[offset + 1 + position]);
+    }
+
+    TapeRef TapeRef::operator[](std::string_view key) const
+    {
+        if (tape == nullptr)
+            return TapeRef();
+        if (tape->Tag(index) != '{')
+            throw std::runtime_error("Not an object");
+
+        TapeRef found;
+        size_t end = tape->Payload(index);
+        for (size_t i = index + 1; i < end; i = tape->Skip(i + 1))
+        {
+            if (tape->String(i) == key)
+                found = TapeRef(tape, i + 1);
+        }
+        return found;
+    }
+
+    TapeRef TapeRef::Begin() const
+    {
+        if (tape == nullptr)
+            return TapeRef();
+        char tag = tape->Tag(index);
+        if ((tag != '{' && tag != '[') || tape->Payload(index) == index + 1)
+            return TapeRef();
+        return TapeRef(tape, tag == '{' ? index + 2 : index + 1);
+    }
+
+    TapeRef TapeRef::Next() const
+    {
+        if (tape == nullptr)
+            return TapeRef();
+        size_t next = tape->Skip(index);
+        if (next >= tape->entries.size())
+            return TapeRef();
+
+        char tag = tape->Tag(next);
+        if (tag == '}' || tag == ']')
+            return TapeRef();
+        return TapeRef(tape, tag == 'k' ? next + 1 : next);
+    }
+
+    std::string_view TapeRef::Key() const
+    {
+        if (tape == nullptr)
+            throw std::runtime_error("Invalid ref");
+        if (index == 0 || tape->Tag(index - 1) != 'k')
+            throw std::runtime_error("Not an object member");
+        return tape->String(index - 1);
+    }
+
+    bool TapeRef::AsBool() const
+    {
+        if (tape == nullptr)
+            throw std::runtime_error("Invalid ref");
+        char tag = tape->Tag(index);
+        if (tag != 't' && tag != 'f')
+            throw std::runtime_error("Not a boolean");
+        return tag == 't';
+    }
+
+    std::string_view TapeRef::AsString() const
+    {
+        if (tape == nullptr)
+            throw std::runtime_error("Invalid ref");
+        if (tape->Tag(index) != '"')
+            throw std::runtime_error("Not a string");
+        return tape->String(index);
+    }
+
+    double TapeRef::AsDouble() const
+    {
+        if (tape == nullptr)
+            throw std::runtime_error("Invalid ref");
+        switch (tape->Tag(index))
+        {
+        case 'l':
+            return static_cast<double>(static_cast<int64_t>(tape->numbers[tape->Payload(index)]));
+        case 'u':
+            return static_cast<double>(tape->numbers[tape->Payload(index)]);
+        case 'n':
+        {
+            double value;
+            if (!ParseDouble(tape->String(index), value))
+                throw std::runtime_error("Number out of range");
+            return value;
+        }
+        default:
+            throw std::runtime_error("Not a number");
+        }
+    }
+
+    int64_t TapeRef::AsInt64() const
+    {
+        if (tape == nullptr)
+            throw std::runtime_error("Invalid ref");
+        if (!IsInteger())
+            throw std::runtime_error("Number is not an int64");
+        uint64_t value = tape->numbers[tape->Payload(index)];
+        if (tape->Tag(index) == 'l' || value <= uint64_t(INT64_MAX))
+            return static_cast<int64_t>(value);
+        throw std::runtime_error("Number is not an int64");
+    }
+
+    uint64_t TapeRef::AsUInt64() const
+    {
+        if (tape == nullptr)
+            throw std::runtime_error("Invalid ref");
+        if (!IsInteger())
+            throw std::runtime_error("Number is not a uint64");
+        uint64_t value = tape->numbers[tape->Payload(index)];
+        if (tape->Tag(index) == 'u' || static_cast<int64_t>(value) >= 0)
+            return value;
+        throw std::runtime_error("Number is not a uint64");
+    }
+
+    bool TapeRef::IsInteger() const
+    {
+        if (tape == nullptr)
+            throw std::runtime_error("Invalid ref");
+        char tag = tape->Tag(index);
+        return tag == 'l' || tag == 'u';
+    }
+
+    void TapeBuilder::Start(char tag)
+    {
+        Value();
+        starts.push_back(tape.entries.size());
+        counts.push_back(0);
+        tape.Append(tag);
+        inArray = tag == '[';
+    }
+
+    // The start entry learns where its container ends. The end entry keeps
+    // the member count, or for an array where its item list starts.
+    void TapeBuilder::End(char tag)
+    {
+        size_t start = starts.back();
+        uint64_t count = counts.back();
+        tape.entries[start] |= tape.entries.size();
+        if (tag == ']')
+        {
+            tape.Append(tag, tape.items.size());
+            tape.items.push_back(count);
+            tape.items.insert(tape.items.end(), pending.end() - count, pending.end());
+            pending.resize(pending.size() - count);
+        }
+        else
+        {
+            tape.Append(tag, count);
+        }
+        starts.pop_back();
+        counts.pop_back();
+        inArray = !starts.empty() && tape.Tag(starts.back()) == '[';
+    }
+
+    void TapeBuilder::onString(std::string_view value)
+    {
+        Value();
+        tape.Append('"', tape.AppendString(value));
+    }
+
+    void TapeBuilder::onNumber(std::string_view lexeme)
+    {
+        Value();
+        int64_t i;
+        uint64_t u;
+        // As in Number::FromLexeme, "-0" is kept as a lexeme.
+        if (ParseInteger(lexeme, i) && !(i == 0 && lexeme[0] == '-'))
+        {
+            tape.Append('l', tape.numbers.size());
+            tape.numbers.push_back(static_cast<uint64_t>(i));
+        }
+        else if (ParseInteger(lexeme, u))
+        {
+            tape.Append('u', tape.numbers.size());
+            tape.numbers.push_back(u);
+        }
+        else
+        {
+            tape.Append('n', tape.AppendString(lexeme));
+        }
+    }
+
+    void TapeBuilder::onBoolean(bool value)
+    {
+        Value();
+        tape.Append(value ? 't' : 'f');
+    }
+
+    void TapeBuilder::onNull()
+    {
+        Value();
+        tape.Append('0');
+    }
+} // namespace Json
@@ -0,0 +1,109 @@
+#include "ThreadPool.hpp"
+
+thread_local ThreadPool *ThreadPool::currentPool = nullptr;
+thread_local size_t ThreadPool::currentIndex = 0;
+
+ThreadPool::ThreadPool(size_t threads) : queued(0), pending(0), stopping(false), next(0)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    for (size_t i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::Run, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    size_t target = currentPool == this ? currentIndex : next++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued++;
+        pending++;
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::TryTake(size_t self, std::function<void()> &task)
+{
+    {
+        Queue &own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+        Queue &victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Run(size_t self)
+{
+    currentPool = this;
+    currentIndex = self;
+
+    std::function<void()> task;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]
+                      { return stopping || queued > 0; });
+            if (queued == 0)
+                return;
+            queued--;
+        }
+
+        // A task is reserved for this worker, so one of the queues holds it.
+        while (!TryTake(self, task))
+            std::this_thread::yield();
+        task();
+        task = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending--;
+            if (pending == 0)
+                idle.notify_all();
+        }
+    }
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]
+              { return pending == 0; });
+}
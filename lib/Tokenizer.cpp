@@ -1,62 +1,41 @@
 #include "Tokenizer.hpp"
+#include "Number.hpp"
+#include "Simd.hpp"
 #include <iostream>
 #include <algorithm>
 
-std::string toLower(const std::string &str)
-{
-    std::string lowerStr;
-    lowerStr.resize(str.size());
-    std::transform(str.begin(), str.end(), lowerStr.begin(), [](unsigned char c)
-                   { return std::tolower(c); });
-    return lowerStr;
-}
-bool isNumber(const std::string &str)
+static_assert(static_cast<size_t>(TOKEN_TYPE::TAG_CLOSE) + 1 == Stats::kTokenTypes,
+              "Stats::kTokenTypes must match TOKEN_TYPE");
+
+bool equalsIgnoreCase(std::string_view str, std::string_view lower)
 {
-    // Check for empty string
-    if (str.empty())
+    if (str.size() != lower.size())
         return false;
-
-    // Iterator to keep track of the current character
-    auto it = str.begin();
-
-    // Check for a leading sign
-    if (*it == '-' || *it == '+')
-        ++it;
-
-    // Check if there are any digits
-    bool hasDigits = std::any_of(it, str.end(), ::isdigit);
-
-    // Check for digits and only one decimal point
-    bool hasDecimalPoint = false;
-    for (; it != str.end(); ++it)
+    for (size_t i = 0; i < str.size(); i++)
     {
-        if (*it == '.')
-        {
-            // Ensure only one decimal point
-            if (hasDecimalPoint)
-                return false;
-            hasDecimalPoint = true;
-        }
-        else if (!std::isdigit(static_cast<unsigned char>(*it)))
-        {
+        if (std::tolower(static_cast<unsigned char>(str[i])) != lower[i])
             return false;
-        }
     }
-
-    // Return true if the string contains digits and follows number formatting rules
-    return hasDigits;
+    return true;
+}
+bool isBooleanTrue(std::string_view str)
+{
+    return equalsIgnoreCase(str, "true");
 }
-bool isBooleanTrue(const std::string &str)
+bool isBooleanFalse(std::string_view str)
 {
-    return toLower(str) == "true";
+    return equalsIgnoreCase(str, "false");
 }
-bool isBooleanFalse(const std::string &str)
+bool isNull(std::string_view str)
 {
-    return toLower(str) == "false";
+    return equalsIgnoreCase(str, "null");
 }
-bool isNull(const std::string &str)
+
+bool isNumberChar(char current_char)
 {
-    return toLower(str) == "null";
+    return std::isdigit(current_char) || current_char == '.' ||
+           current_char == 'e' || current_char == 'E' ||
+           current_char == '+' || current_char == '-';
 }
 
 bool isSymbol(char current_char)
@@ -70,221 +49,302 @@ bool isSymbol(char current_char)
            current_char == ':' || current_char == '\n';
 }
 
-std::vector<TokenJson> Tokenizer::TokenizeJson(std::string &jsonString)
+bool JsonLexer::Lex(TokenJson &token)
 {
-    unsigned int current = 0;
-    std::vector<TokenJson> tokens;
     char current_char;
+    incomplete = false;
 
-    while (current < jsonString.size())
+    while (current < input.size())
     {
-        current_char = jsonString[current];
+        current = Simd::SkipWhitespace(input.data(), current, input.size());
+        if (current >= input.size())
+            break;
+        current_char = input[current];
 
         if (current_char == '{')
         {
-            tokens.push_back(TokenJson(TOKEN_TYPE::BRACE_OPEN, current_char));
+            token = TokenJson(TOKEN_TYPE::BRACE_OPEN, input.substr(current, 1));
             current++;
-            continue;
+            return true;
         }
 
         if (current_char == '}')
         {
-            tokens.push_back(TokenJson(TOKEN_TYPE::BRACE_CLOSE, current_char));
+            token = TokenJson(TOKEN_TYPE::BRACE_CLOSE, input.substr(current, 1));
             current++;
-            continue;
+            return true;
         }
 
         if (current_char == '[')
         {
-            tokens.push_back(TokenJson(TOKEN_TYPE::BRACKET_OPEN, current_char));
+            token = TokenJson(TOKEN_TYPE::BRACKET_OPEN, input.substr(current, 1));
             current++;
-            continue;
+            return true;
         }
         if (current_char == ']')
         {
-            tokens.push_back(TokenJson(TOKEN_TYPE::BRACKET_CLOSE, current_char));
+            token = TokenJson(TOKEN_TYPE::BRACKET_CLOSE, input.substr(current, 1));
             current++;
-            continue;
+            return true;
         }
 
         if (current_char == ':')
         {
-            tokens.push_back(TokenJson(TOKEN_TYPE::COLON, current_char));
+            token = TokenJson(TOKEN_TYPE::COLON, input.substr(current, 1));
             current++;
-            continue;
+            return true;
         }
 
         if (current_char == ',')
         {
-            tokens.push_back(TokenJson(TOKEN_TYPE::COMMA, current_char));
+            token = TokenJson(TOKEN_TYPE::COMMA, input.substr(current, 1));
             current++;
-            continue;
+            return true;
         }
 
         if (current_char == '"')
         {
-            std::string value = "";
-            current_char = jsonString[++current];
-            while (current_char != '"')
+            // Jump between quotes and backslashes; escape sequences are kept
+            // as written and the body is copied out in one piece.
+            size_t start = ++current;
+            current = Simd::FindQuoteOrBackslash(input.data(), current, input.size());
+            while (current < input.size() && input[current] == '\\')
+                current = Simd::FindQuoteOrBackslash(input.data(), current + 2, input.size());
+            if (current >= input.size())
             {
-                value += current_char;
-                current_char = jsonString[++current];
+                current = start - 1;
+                if (final)
+                    throw std::runtime_error("Unterminated string");
+                incomplete = true;
+                return false;
             }
+            token = TokenJson(TOKEN_TYPE::STRING, input.substr(start, current - start));
             current++;
-            tokens.push_back(TokenJson(TOKEN_TYPE::STRING, value));
-            continue;
+            return true;
+        }
+
+        if (current_char == '-' || std::isdigit(current_char))
+        {
+            size_t start = current;
+            while (current < input.size() && isNumberChar(input[current]))
+                current++;
+            if (current >= input.size() && !final)
+            {
+                current = start;
+                incomplete = true;
+                return false;
+            }
+            std::string_view value = input.substr(start, current - start);
+            if (!IsNumberLexeme(value))
+                throw std::runtime_error("Invalid number: " + std::string(value));
+            token = TokenJson(TOKEN_TYPE::NUMBER, value);
+            return true;
         }
 
-        if (std::isalnum(current_char))
+        if (std::isalpha(current_char))
         {
-            std::string value = "";
-            while (std::isalnum(current_char) || current_char == '.')
+            size_t start = current;
+            while (current < input.size() && std::isalnum(input[current]))
+                current++;
+            if (current >= input.size() && !final)
             {
-                value += current_char;
-                current_char = jsonString[++current];
+                current = start;
+                incomplete = true;
+                return false;
             }
-            if (isNumber(value))
-                tokens.push_back(TokenJson(TOKEN_TYPE::NUMBER, value));
-            else if (isBooleanTrue(value))
-                tokens.push_back(TokenJson(TOKEN_TYPE::TRUE, value));
+            std::string_view value = input.substr(start, current - start);
+            if (isBooleanTrue(value))
+                token = TokenJson(TOKEN_TYPE::TRUE, value);
             else if (isBooleanFalse(value))
-                tokens.push_back(TokenJson(TOKEN_TYPE::FALSE, value));
+                token = TokenJson(TOKEN_TYPE::FALSE, value);
             else if (isNull(value))
-                tokens.push_back(TokenJson(TOKEN_TYPE::NONE, value));
+                token = TokenJson(TOKEN_TYPE::NONE, value);
             else
-                throw std::runtime_error("Unexpected value: " + value);
-            continue;
+                throw std::runtime_error("Unexpected value: " + std::string(value));
+            return true;
         }
         current++;
     }
+    return false;
+}
+
+std::vector<TokenJson> Tokenizer::TokenizeJson(std::string_view jsonString)
+{
+    Stats::Operation operation(Stats::PHASE::TOKENIZE);
+    Stats::CountBytesParsed(jsonString.size());
+    JsonLexer lexer(jsonString);
+    std::vector<TokenJson> tokens;
+    TokenJson token;
+
+    while (lexer.NextToken(token))
+        tokens.push_back(token);
 
     return tokens;
 }
-std::vector<TokenXml> Tokenizer::TokenizeXml(std::string &XmlString)
+std::vector<std::pair<std::string_view, std::string_view>> SplitXmlAttributes(std::string_view attributes)
+{
+    std::vector<std::pair<std::string_view, std::string_view>> result;
+    size_t pos = 0;
+
+    while (pos < attributes.size())
+    {
+        size_t equals = attributes.find('=', pos);
+        if (equals == std::string_view::npos)
+            break;
+        size_t open = attributes.find('"', equals);
+        if (open == std::string_view::npos)
+            break;
+        size_t close = attributes.find('"', open + 1);
+        if (close == std::string_view::npos)
+            break;
+
+        std::string_view key = attributes.substr(pos, equals - pos);
+        size_t first = key.find_first_not_of(' ');
+        size_t last = key.find_last_not_of(' ');
+        key = first == std::string_view::npos ? std::string_view() : key.substr(first, last - first + 1);
+
+        result.emplace_back(key, attributes.substr(open + 1, close - open - 1));
+        pos = close + 1;
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string_view, std::string_view>> TokenXml::Attributes() const
+{
+    return SplitXmlAttributes(this->attributes);
+}
+
+bool XmlLexer::Cut(size_t start)
+{
+    current = start;
+    if (final)
+        throw std::runtime_error("Unexpected end of input");
+    incomplete = true;
+    return false;
+}
+
+bool XmlLexer::Lex(TokenXml &token)
 {
-    unsigned int current = 0;
-    std::vector<TokenXml> tokens;
     char current_char;
-    bool tagname_complete = true;
-    std::string attrib_info ="";
+    incomplete = false;
+
+    if (!pendingClose.empty())
+    {
+        token = TokenXml(TOKEN_TYPE::TAG_CLOSE, pendingClose);
+        pendingClose = std::string_view();
+        return true;
+    }
 
-    while (current < XmlString.size())
+    while (current < input.size())
     {
-        current_char = XmlString[current];
+        current_char = input[current];
 
         if (current_char == '<')
         {
-            std::string tagname = "";
-            std::string attrib_info = "";
-            if (XmlString[current + 1] == '/')
+            size_t start = current;
+
+            if (input.compare(current, 4, "<!--") == 0)
             {
-                current++;
-                current_char = XmlString[++current];
-                while (current_char != '>')
-                {
-                    tagname += current_char;
-                    current_char = XmlString[++current];
-                }
-
-                tokens.push_back(TokenXml(TOKEN_TYPE::TAG_CLOSE, tagname));
-                current++;
+                size_t end = input.find("-->", current + 4);
+                if (end == std::string_view::npos)
+                    return Cut(start);
+                current = end + 3;
                 continue;
             }
-        }
-        if (current_char == '<')
-        {
-            std::string tagname = "";
-            current_char = XmlString[++current];
-            while (current_char != '>')
+            if (input.compare(current, 9, "<![CDATA[") == 0)
             {
-                if (current_char == ' ')
-                    tagname_complete = false;
-
-                if(tagname_complete)
-                    tagname += current_char;
-                else
-                    attrib_info += current_char;
-                current_char = XmlString[++current];
+                size_t end = input.find("]]>", current + 9);
+                if (end == std::string_view::npos)
+                    return Cut(start);
+                token = TokenXml(TOKEN_TYPE::STRING, input.substr(current + 9, end - current - 9));
+                current = end + 3;
+                return true;
             }
-            tagname_complete = true;
-            current++;
-            TokenXml token = TokenXml(TOKEN_TYPE::TAG_OPEN, tagname);
-            std::string key, value;
-            bool isKey = true, inQuotes = false;
 
-            for (char ch : attrib_info)
+            size_t end = input.find('>', current);
+            if (end == std::string_view::npos)
+            {
+                // "<" alone may still turn out to be a comment or CDATA.
+                return Cut(start);
+            }
+            current = end + 1;
+
+            if (start + 1 < input.size() && (input[start + 1] == '?' || input[start + 1] == '!'))
+                continue;
+
+            if (input[start + 1] == '/')
             {
-                if (ch == '=')
-                {
-                    isKey = false;
-                }
-                else if (ch == '\"')
-                {
-                    inQuotes = !inQuotes;
-                    if (!inQuotes)
-                    {
-                        token.addAttribute(key, value);
-                        key.clear();
-                        value.clear();
-                        isKey = true;
-                    }
-                }
-                else if (ch == ' ' && !inQuotes)
-                {
-                    // Skip spaces outside of quotes
-                }
-                else
-                {
-                    if (isKey)
-                    {
-                        key += ch;
-                    }
-                    else
-                    {
-                        value += ch;
-                    }
-                }
+                token = TokenXml(TOKEN_TYPE::TAG_CLOSE, input.substr(start + 2, end - start - 2));
+                return true;
             }
-            tokens.push_back(token);
 
-            continue;
+            std::string_view tag = input.substr(start + 1, end - start - 1);
+            bool selfClosing = !tag.empty() && tag.back() == '/';
+            if (selfClosing)
+                tag.remove_suffix(1);
+
+            size_t space = tag.find_first_of(" \t\r\n");
+            token = TokenXml(TOKEN_TYPE::TAG_OPEN, tag.substr(0, space));
+            if (space != std::string_view::npos)
+                token.attributes = tag.substr(space + 1);
+            if (selfClosing)
+                pendingClose = token.value;
+            return true;
         }
 
         if (current_char == '"')
         {
-            std::string value = "";
-            current_char = XmlString[++current];
-            while (current_char != '"')
-            {
-                value += current_char;
-                current_char = XmlString[++current];
-            }
-            current++;
-            tokens.push_back(TokenXml(TOKEN_TYPE::STRING, value));
-            continue;
+            size_t end = input.find('"', current + 1);
+            if (end == std::string_view::npos)
+                return Cut(current);
+            token = TokenXml(TOKEN_TYPE::STRING, input.substr(current + 1, end - current - 1));
+            current = end + 1;
+            return true;
         }
 
         if (std::isalnum(current_char) || isSymbol(current_char))
         {
-            std::string value = "";
-            while (std::isalnum(current_char) || isSymbol(current_char) || std::isspace(current_char))
-            {
-                value += current_char;
-                current_char = XmlString[++current];
-            }
-            if (isNumber(value))
-                tokens.push_back(TokenXml(TOKEN_TYPE::NUMBER, value));
+            size_t start = current;
+            while (current < input.size() &&
+                   (std::isalnum(input[current]) || isSymbol(input[current]) || std::isspace(input[current])))
+                current++;
+            if (current >= input.size() && !final)
+                return Cut(start);
+
+            std::string_view value = input.substr(start, current - start);
+            size_t first = value.find_first_not_of(" \t\r\n");
+            if (first == std::string_view::npos)
+                continue;
+            size_t last = value.find_last_not_of(" \t\r\n");
+            value = value.substr(first, last - first + 1);
+
+            if (IsNumberLexeme(value))
+                token = TokenXml(TOKEN_TYPE::NUMBER, value);
             else if (isBooleanTrue(value))
-                tokens.push_back(TokenXml(TOKEN_TYPE::TRUE, value));
+                token = TokenXml(TOKEN_TYPE::TRUE, value);
             else if (isBooleanFalse(value))
-                tokens.push_back(TokenXml(TOKEN_TYPE::FALSE, value));
+                token = TokenXml(TOKEN_TYPE::FALSE, value);
             else if (isNull(value))
-                tokens.push_back(TokenXml(TOKEN_TYPE::NONE, value));
+                token = TokenXml(TOKEN_TYPE::NONE, value);
             else
-                tokens.push_back(TokenXml(TOKEN_TYPE::STRING, value));
-            continue;
+                token = TokenXml(TOKEN_TYPE::STRING, value);
+            return true;
         }
         current++;
     }
+    return false;
+}
+
+std::vector<TokenXml> Tokenizer::TokenizeXml(std::string_view XmlString)
+{
+    Stats::Operation operation(Stats::PHASE::TOKENIZE);
+    Stats::CountBytesParsed(XmlString.size());
+    XmlLexer lexer(XmlString);
+    std::vector<TokenXml> tokens;
+    TokenXml token;
+
+    while (lexer.NextToken(token))
+        tokens.push_back(token);
+
     return tokens;
-};
+}
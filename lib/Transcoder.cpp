@@ -0,0 +1,317 @@
+#include "Transcoder.hpp"
+#include <algorithm>
+#include <functional>
+#include "Escape.hpp"
+
+namespace Json
+{
+    void XmlTranscoder::Open(std::string_view name)
+    {
+        if (written.back())
+            out.NewLine();
+        else if (written.size() > 1)
+        {
+            out.Indent();
+            out.Break();
+        }
+        written.back() = true;
+
+        out.Write('<');
+        out.Write(name);
+        out.Write('>');
+    }
+
+    void XmlTranscoder::Close(std::string_view name)
+    {
+        out.Write("</");
+        out.Write(name);
+        out.Write('>');
+    }
+
+    // Maps and arrays nested in an array, and maps that are member values,
+    // are wrapped in an element. An array that is a member value is not: its
+    // items are the elements.
+    void XmlTranscoder::StartContainer(bool isMap)
+    {
+        if (stack.empty())
+        {
+            stack.push_back(Frame{isMap, false, std::string(), std::string()});
+            return;
+        }
+
+        std::string name = stack.back().name;
+        if (!isMap && stack.back().isMap)
+        {
+            stack.push_back(Frame{false, false, std::string(), name});
+            return;
+        }
+
+        Open(name);
+        written.push_back(false);
+        stack.push_back(Frame{isMap, true, name, isMap ? std::string() : name});
+    }
+
+    void XmlTranscoder::EndContainer()
+    {
+        Frame &frame = stack.back();
+        if (frame.element)
+        {
+            if (written.back())
+            {
+                out.Dedent();
+                out.Break();
+            }
+            written.pop_back();
+            Close(frame.tag);
+        }
+        stack.pop_back();
+    }
+
+    void XmlTranscoder::onString(std::string_view value)
+    {
+        if (stack.empty())
+        {
+            WriteJsonStringAsXml(out, value);
+            return;
+        }
+        Open(stack.back().name);
+        WriteJsonStringAsXml(out, value);
+        Close(stack.back().name);
+    }
+
+    void XmlTranscoder::onNumber(std::string_view lexeme)
+    {
+        if (stack.empty())
+        {
+            out.Write(lexeme);
+            return;
+        }
+        Open(stack.back().name);
+        out.Write(lexeme);
+        Close(stack.back().name);
+    }
+
+    void XmlTranscoder::onBoolean(bool value)
+    {
+        onNumber(value ? "true" : "false");
+    }
+
+    void XmlTranscoder::onNull()
+    {
+        onNumber("null");
+    }
+} // namespace Json
+
+namespace Xml
+{
+    void JsonTranscoder::NameSet::Index(size_t name)
+    {
+        size_t mask = index.size() - 1;
+        size_t slot = std::hash<std::string_view>()(names[name]) & mask;
+        while (index[slot] != 0)
+            slot = (slot + 1) & mask;
+        index[slot] = name + 1;
+    }
+
+    // False when the name is already in the set.
+    bool JsonTranscoder::NameSet::Insert(std::string_view name)
+    {
+        if (used <= kLinearNames)
+        {
+            for (size_t i = 0; i < used; i++)
+            {
+                if (names[i] == name)
+                    return false;
+            }
+        }
+        else
+        {
+            size_t mask = index.size() - 1;
+            for (size_t slot = std::hash<std::string_view>()(name) & mask; index[slot] != 0; slot = (slot + 1) & mask)
+            {
+                if (names[index[slot] - 1] == name)
+                    return false;
+            }
+        }
+
+        if (names.size() <= used)
+            names.emplace_back();
+        names[used++].assign(name);
+
+        if (used > kLinearNames)
+        {
+            // Kept at most half full. The table still holds the previous
+            // element's names when this one first outgrows the linear scan.
+            bool grow = used * 2 > index.size();
+            if (grow || used == kLinearNames + 1)
+            {
+                if (grow)
+                    index.resize(index.size() < 32 ? 32 : index.size() * 2);
+                std::fill(index.begin(), index.end(), 0);
+                for (size_t i = 0; i < used; i++)
+                    Index(i);
+            }
+            else
+            {
+                Index(used - 1);
+            }
+        }
+        return true;
+    }
+
+    // The run's first element, written as a plain member value, becomes the
+    // first item: an opening bracket goes in front and, when pretty-printing,
+    // its lines move one level in.
+    void JsonTranscoder::StartArray(Frame &frame)
+    {
+        first.assign(out.Tail(frame.runStart));
+        out.Rewind(frame.runStart, out.Depth());
+        out.Write('[');
+        out.Indent();
+        out.Break();
+        if (!out.IsPretty())
+        {
+            out.Write(first);
+        }
+        else
+        {
+            std::string_view rest(first);
+            size_t line = rest.find('\n');
+            while (line != std::string_view::npos)
+            {
+                out.Write(rest.substr(0, line + 1));
+                for (unsigned int i = 0; i < out.IndentWidth(); i++)
+                    out.Write(' ');
+                rest.remove_prefix(line + 1);
+                line = rest.find('\n');
+            }
+            out.Write(rest);
+        }
+    }
+
+    void JsonTranscoder::EndRun(size_t level)
+    {
+        Frame &frame = frames[level];
+        if (frame.runCount > 1)
+        {
+            out.Dedent();
+            out.Break();
+            out.Write(']');
+        }
+        frame.runCount = 0;
+        if (heldLevel == level)
+        {
+            heldLevel = kNoLevel;
+            out.Release();
+        }
+    }
+
+    void JsonTranscoder::SetText(TEXT kind, std::string_view text)
+    {
+        Frame &frame = frames[depth - 1];
+        if (frame.kind == TEXT::NONE && !frame.hasChildren)
+        {
+            frame.kind = kind;
+            frame.text.assign(text);
+        }
+    }
+
+    void JsonTranscoder::onStartElement(std::string_view name, std::string_view attributes)
+    {
+        if (frames.size() <= depth)
+            frames.emplace_back();
+
+        if (depth == 0)
+        {
+            out.Write('{');
+            out.Indent();
+            out.Break();
+            out.Write('"');
+            out.Write(name);
+            out.Write(out.IsPretty() ? "\": " : "\":");
+        }
+        else
+        {
+            size_t level = depth - 1;
+            Frame &parent = frames[level];
+            if (!parent.hasChildren)
+            {
+                parent.hasChildren = true;
+                out.Write('{');
+                out.Indent();
+            }
+
+            if (parent.runCount > 0 && parent.runName == name)
+            {
+                if (parent.runCount == 1)
+                {
+                    StartArray(parent);
+                    if (heldLevel == level)
+                    {
+                        heldLevel = kNoLevel;
+                        out.Release();
+                    }
+                }
+                out.Write(',');
+                out.Break();
+                parent.runCount++;
+            }
+            else
+            {
+                EndRun(level);
+                if (!parent.runs.Insert(name))
+                    throw NonAdjacentRepeat(name);
+                if (parent.members++ > 0)
+                    out.Write(',');
+                out.Break();
+                out.Write('"');
+                out.Write(name);
+                out.Write(out.IsPretty() ? "\": " : "\":");
+
+                parent.runName.assign(name);
+                parent.runCount = 1;
+                parent.runStart = out.Written();
+                if (heldLevel == kNoLevel && !out.Holds(parent.runStart))
+                {
+                    heldLevel = level;
+                    out.Hold(parent.runStart);
+                }
+            }
+        }
+
+        Frame &frame = frames[depth++];
+        frame.kind = TEXT::NONE;
+        frame.text.clear();
+        frame.hasChildren = false;
+        frame.members = 0;
+        frame.runCount = 0;
+        frame.runs.Clear();
+    }
+
+    void JsonTranscoder::onEndElement(std::string_view name)
+    {
+        size_t level = depth - 1;
+        Frame &frame = frames[level];
+
+        if (frame.hasChildren)
+        {
+            EndRun(level);
+            out.Dedent();
+            out.Break();
+            out.Write('}');
+        }
+        else if (frame.kind == TEXT::STRING)
+            WriteXmlTextAsJson(out, frame.text);
+        else if (frame.kind == TEXT::LITERAL)
+            out.Write(frame.text);
+        else
+            out.Write("{}");
+
+        if (--depth == 0)
+        {
+            out.Dedent();
+            out.Break();
+            out.Write('}');
+        }
+    }
+} // namespace Xml
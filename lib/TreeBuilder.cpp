@@ -0,0 +1,183 @@
+#include "TreeBuilder.hpp"
+
+namespace Json
+{
+    void TreeBuilder::Add(Object *value)
+    {
+        if (stack.empty())
+        {
+            root = value;
+            return;
+        }
+
+        Object *top = stack.back();
+        Object *replaced = nullptr;
+        if (top->getType() != OBJECT_TYPE::MAP)
+            static_cast<JsonArray *>(top)->AddElement(value);
+        else if (symbols != nullptr)
+            replaced = static_cast<JsonMap *>(top)->AddSymbol(key, value);
+        else
+            replaced = static_cast<JsonMap *>(top)->AddElement(key, value);
+        if (arena == nullptr)
+            delete replaced;
+    }
+
+    // Every open container is already attached under the root.
+    void TreeBuilder::Discard()
+    {
+        if (arena == nullptr)
+            delete root;
+        stack.clear();
+        root = nullptr;
+    }
+
+    void TreeBuilder::onKey(std::string_view key)
+    {
+        if (symbols != nullptr)
+        {
+            this->key = symbols->Intern(key);
+        }
+        else
+        {
+            keyCopy.assign(key);
+            this->key = keyCopy;
+        }
+    }
+
+    void TreeBuilder::onStartObject()
+    {
+        JsonMap *map = Make<JsonMap>();
+        Add(map);
+        stack.push_back(map);
+    }
+
+    void TreeBuilder::onStartArray()
+    {
+        JsonArray *array = Make<JsonArray>();
+        Add(array);
+        stack.push_back(array);
+    }
+
+    void TreeBuilder::onString(std::string_view value)
+    {
+        Add(Make<JsonString>(value));
+    }
+
+    void TreeBuilder::onNumber(std::string_view lexeme)
+    {
+        Add(Make<JsonNumber>(lexeme));
+    }
+
+    void TreeBuilder::onBoolean(bool value)
+    {
+        Add(Make<JsonBoolean>(value));
+    }
+
+    void TreeBuilder::onNull()
+    {
+        Add(Make<JsonNull>());
+    }
+} // namespace Json
+
+namespace Xml
+{
+    void TreeBuilder::AddChild(Frame &parent, std::string_view name, Object *value)
+    {
+        if (parent.children == nullptr)
+            parent.children = Make<XmlMap>();
+
+        Object *existing = parent.children->Find(name);
+        if (existing == nullptr)
+        {
+            if (symbols != nullptr)
+                parent.children->AddSymbol(symbols->Intern(name), value);
+            else
+                parent.children->AddElement(name, value);
+        }
+        else if (existing->getType() == OBJECT_TYPE::ARRAY)
+        {
+            static_cast<XmlArray *>(existing)->AddElement(value);
+        }
+        else
+        {
+            XmlArray *array = Make<XmlArray>();
+            array->AddElement(existing);
+            array->AddElement(value);
+            parent.children->AddElement(name, array);
+        }
+    }
+
+    // Open elements are not attached yet, so each frame frees its own nodes.
+    void TreeBuilder::Discard()
+    {
+        if (arena == nullptr)
+        {
+            for (Frame &frame : stack)
+            {
+                delete frame.children;
+                delete frame.text;
+            }
+            delete root;
+        }
+        stack.clear();
+        root = nullptr;
+    }
+
+    void TreeBuilder::onStartElement(std::string_view name, std::string_view attributes)
+    {
+        stack.push_back(Frame{nullptr, nullptr});
+    }
+
+    void TreeBuilder::onEndElement(std::string_view name)
+    {
+        Frame frame = stack.back();
+        stack.pop_back();
+
+        Object *value = frame.children;
+        if (value == nullptr)
+            value = frame.text;
+        else if (arena == nullptr)
+            delete frame.text;
+        if (value == nullptr)
+            value = Make<XmlMap>();
+
+        if (stack.empty())
+        {
+            XmlMap *map = Make<XmlMap>();
+            if (symbols != nullptr)
+                map->AddSymbol(symbols->Intern(name), value);
+            else
+                map->AddElement(name, value);
+            root = map;
+        }
+        else
+        {
+            AddChild(stack.back(), name, value);
+        }
+    }
+
+    // Only the first text run of an element is kept.
+    void TreeBuilder::onString(std::string_view value)
+    {
+        if (stack.back().text == nullptr)
+            stack.back().text = Make<XmlString>(value);
+    }
+
+    void TreeBuilder::onNumber(std::string_view lexeme)
+    {
+        if (stack.back().text == nullptr)
+            stack.back().text = Make<XmlNumber>(lexeme);
+    }
+
+    void TreeBuilder::onBoolean(bool value)
+    {
+        if (stack.back().text == nullptr)
+            stack.back().text = Make<XmlBoolean>(value);
+    }
+
+    void TreeBuilder::onNull()
+    {
+        if (stack.back().text == nullptr)
+            stack.back().text = Make<XmlNull>();
+    }
+} // namespace Xml
@@ -0,0 +1,100 @@
+#include "Writer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+
+Writer::Writer(std::string &out, bool pretty, unsigned int indentWidth)
+    : buffer(&out), start(out.size()), flushed(0), stream(nullptr), fd(-1), pretty(pretty), indentWidth(indentWidth), depth(0),
+      hold(kNoHold), flushAt(kChunkSize)
+{
+}
+
+Writer::Writer(std::ostream &out, bool pretty, unsigned int indentWidth)
+    : buffer(&chunk), start(0), flushed(0), stream(&out), fd(-1), pretty(pretty), indentWidth(indentWidth), depth(0),
+      hold(kNoHold), flushAt(kChunkSize)
+{
+    chunk.reserve(kChunkSize + kChunkSize / 4);
+}
+
+Writer::Writer(int fd, bool pretty, unsigned int indentWidth)
+    : buffer(&chunk), start(0), flushed(0), stream(nullptr), fd(fd), pretty(pretty), indentWidth(indentWidth), depth(0),
+      hold(kNoHold), flushAt(kChunkSize)
+{
+    chunk.reserve(kChunkSize + kChunkSize / 4);
+}
+
+Writer::~Writer()
+{
+    try
+    {
+        Release();
+        Flush();
+    }
+    catch (...)
+    {
+    }
+}
+
+void Writer::NewLine()
+{
+    buffer->push_back('\n');
+    if (pretty)
+        buffer->append(depth * indentWidth, ' ');
+    FlushIfFull();
+}
+
+// Only output before the hold is passed on. While a hold keeps the chunk
+// from emptying, the next attempt waits for another kChunkSize bytes.
+void Writer::Flush()
+{
+    if (buffer != &chunk || chunk.empty())
+        return;
+
+    size_t count = chunk.size();
+    if (hold != kNoHold)
+        count = hold <= flushed ? 0 : std::min(count, hold - flushed);
+
+    if (stream != nullptr)
+    {
+        stream->write(chunk.data(), count);
+    }
+    else
+    {
+        const char *data = chunk.data();
+        size_t remaining = count;
+        while (remaining > 0)
+        {
+            ssize_t written = ::write(fd, data, remaining);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                chunk.clear();
+                throw std::runtime_error("Failed to write output");
+            }
+            data += written;
+            remaining -= written;
+        }
+    }
+    flushed += count;
+    chunk.erase(0, count);
+    flushAt = chunk.size() + kChunkSize;
+}
+
+std::string_view Writer::Tail(size_t position) const
+{
+    size_t base = buffer == &chunk ? flushed : 0;
+    if (position < base)
+        throw std::logic_error("Output already flushed");
+    return std::string_view(*buffer).substr(start + position - base);
+}
+
+void Writer::Rewind(size_t position, unsigned int depth)
+{
+    size_t base = buffer == &chunk ? flushed : 0;
+    if (position < base)
+        throw std::logic_error("Output already flushed");
+    buffer->resize(start + position - base);
+    this->depth = depth;
+}
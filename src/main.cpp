@@ -1,29 +1,545 @@
+#include "MappedFile.hpp"
 #include "Parser.hpp"
+#include "PushParser.hpp"
+#include "ThreadPool.hpp"
+#include "Transcoder.hpp"
+#include "Writer.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
-#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <fcntl.h>
+#include <unistd.h>
 
-int main(){
-    std::string filepath = ""; // example code 
-    std::ifstream file(filepath);
-
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file" << std::endl;
-        return 1; 
-    }
-
-    std::string line;
-    std::string jsonString;
-    
-    // Read the file line by line
-    while (std::getline(file, line)) {
-        jsonString += line;
-    }
-    file.close();
-    
-    Parser parser;
-    Xml::Object* obj = parser.ParseXml(jsonString);
-    std::cout <<obj->toXmlString() << std::endl;
-    
-    return 0;
-}
\ No newline at end of file
+namespace fs = std::filesystem;
+
+namespace
+{
+    const char *kUsage =
+        "usage: MyProject MODE [options] [INPUT [OUTPUT]]\n"
+        "\n"
+        "modes:\n"
+        "  json2xml   convert JSON to XML\n"
+        "  xml2json   convert XML to JSON\n"
+        "  validate   check syntax, write nothing\n"
+        "  reformat   rewrite in the same format (pretty-printed by default)\n"
+        "\n"
+        "INPUT is a file (memory-mapped), a directory, or - for stdin (default).\n"
+        "OUTPUT is a file, or - for stdout (default). json2xml and validate\n"
+        "stream stdin: input is read in chunks and never held in full.\n"
+        "xml2json and reformat read it in full, since xml2json falls back to\n"
+        "the tree when repeated element names are not adjacent.\n"
+        "\n"
+        "A directory INPUT converts every .json/.xml file below it into the\n"
+        "same relative path under the OUTPUT directory. json2xml and\n"
+        "validation run in memory bounded by nesting depth per job; xml2json\n"
+        "holds a file's output until it is complete.\n"
+        "\n"
+        "options:\n"
+        "  -j, --jobs N     worker threads for a directory (default: all cores)\n"
+        "  --indent N       pretty-print with N spaces, 0 for compact output\n"
+        "                   (default: 2 for reformat, 0 otherwise)\n"
+        "  --from FORMAT    json or xml, for validate/reformat input that has\n"
+        "                   no .json/.xml extension (default: guessed)\n"
+        "  -q, --quiet      no throughput summary on stderr\n";
+
+    constexpr size_t kReadSize = 64 * 1024;
+
+    enum class MODE
+    {
+        JSON_TO_XML,
+        XML_TO_JSON,
+        VALIDATE,
+        REFORMAT
+    };
+
+    enum class FORMAT
+    {
+        UNKNOWN,
+        JSON,
+        XML
+    };
+
+    struct Options
+    {
+        MODE mode = MODE::VALIDATE;
+        std::string input = "-";
+        std::string output = "-";
+        size_t jobs = 0;
+        int indent = -1;
+        FORMAT from = FORMAT::UNKNOWN;
+        bool quiet = false;
+    };
+
+    struct Summary
+    {
+        std::atomic<size_t> files{0};
+        std::atomic<size_t> failed{0};
+        std::atomic<size_t> bytesIn{0};
+        std::atomic<size_t> bytesOut{0};
+    };
+
+    // Parser and documents reused by every input a thread handles.
+    struct Worker
+    {
+        Parser parser;
+        Json::Document json;
+        Xml::Document xml;
+    };
+
+    // Output written to a temporary name and renamed into place once
+    // complete, so a failed conversion leaves no partial file behind.
+    class OutputFile
+    {
+    private:
+        std::string path;
+        std::string temp;
+        int fd;
+
+    public:
+        explicit OutputFile(const std::string &path) : path(path), temp(path + ".tmp")
+        {
+            fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0)
+                throw std::runtime_error("Could not create " + temp + ": " + std::strerror(errno));
+        }
+        ~OutputFile()
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+                ::unlink(temp.c_str());
+            }
+        }
+
+        OutputFile(const OutputFile &) = delete;
+        OutputFile &operator=(const OutputFile &) = delete;
+
+        inline int Fd() const { return fd; }
+
+        void Commit()
+        {
+            int result = ::close(fd);
+            fd = -1;
+            if (result != 0 || ::rename(temp.c_str(), path.c_str()) != 0)
+            {
+                int error = errno;
+                ::unlink(temp.c_str());
+                throw std::runtime_error("Could not write " + path + ": " + std::strerror(error));
+            }
+        }
+    };
+
+    FORMAT InputFormat(MODE mode)
+    {
+        if (mode == MODE::JSON_TO_XML)
+            return FORMAT::JSON;
+        if (mode == MODE::XML_TO_JSON)
+            return FORMAT::XML;
+        return FORMAT::UNKNOWN;
+    }
+
+    FORMAT FormatOfPath(const fs::path &path)
+    {
+        if (path.extension() == ".json")
+            return FORMAT::JSON;
+        if (path.extension() == ".xml")
+            return FORMAT::XML;
+        return FORMAT::UNKNOWN;
+    }
+
+    // XML starts with '<', anything else is taken for JSON.
+    FORMAT Sniff(std::string_view input)
+    {
+        size_t first = input.find_first_not_of(" \t\r\n");
+        if (first == std::string_view::npos)
+            return FORMAT::UNKNOWN;
+        return input[first] == '<' ? FORMAT::XML : FORMAT::JSON;
+    }
+
+    FORMAT Resolve(const Options &options, FORMAT known, std::string_view input)
+    {
+        FORMAT format = InputFormat(options.mode);
+        if (format == FORMAT::UNKNOWN)
+            format = options.from;
+        if (format == FORMAT::UNKNOWN)
+            format = known;
+        if (format == FORMAT::UNKNOWN)
+            format = Sniff(input);
+        return format;
+    }
+
+    int Indent(const Options &options)
+    {
+        if (options.indent >= 0)
+            return options.indent;
+        return options.mode == MODE::REFORMAT ? 2 : 0;
+    }
+
+    // Reads up to kReadSize bytes of `fd` into `buffer`; empty at end of input.
+    std::string_view ReadChunk(int fd, std::string &buffer)
+    {
+        buffer.resize(kReadSize);
+        while (true)
+        {
+            ssize_t count = ::read(fd, &buffer[0], buffer.size());
+            if (count >= 0)
+                return std::string_view(buffer.data(), count);
+            if (errno != EINTR)
+                throw std::runtime_error(std::string("Could not read input: ") + std::strerror(errno));
+        }
+    }
+
+    // Handles a whole input held in memory.
+    void Process(Worker &worker, MODE mode, FORMAT format, std::string_view input, Writer &out)
+    {
+        Parser &parser = worker.parser;
+        switch (mode)
+        {
+        case MODE::JSON_TO_XML:
+            parser.JsonToXml(input, out);
+            break;
+        case MODE::XML_TO_JSON:
+            parser.XmlToJson(input, out);
+            break;
+        case MODE::VALIDATE:
+            if (format == FORMAT::JSON)
+            {
+                Json::Handler ignore;
+                parser.ParseJson(input, ignore);
+            }
+            else
+            {
+                Xml::Handler ignore;
+                parser.ParseXml(input, ignore);
+            }
+            return;
+        case MODE::REFORMAT:
+            if (format == FORMAT::JSON)
+            {
+                parser.ParseJsonDocument(input, worker.json);
+                parser.UnParseJson(*worker.json.Root(), out);
+            }
+            else
+            {
+                parser.ParseXmlDocument(input, worker.xml);
+                parser.UnParseXml(*worker.xml.Root(), out);
+            }
+            break;
+        }
+        out.Write('\n');
+    }
+
+    // Feeds the rest of `fd`, after the `first` chunk already read, to a
+    // push reader.
+    template <typename PushReader, typename Handler>
+    void Pump(Handler &handler, int fd, std::string_view first, std::string &buffer, Summary &summary)
+    {
+        PushReader reader(handler);
+        for (std::string_view chunk = first; !chunk.empty(); chunk = ReadChunk(fd, buffer))
+        {
+            summary.bytesIn += chunk.size();
+            reader.feed(chunk);
+        }
+        reader.finish();
+    }
+
+    // Standard input, streamed through the push readers. Reformatting needs
+    // the whole tree and xml2json may fall back to it, so their input is
+    // read in full first.
+    void Stream(const Options &options, Writer &out, Summary &summary)
+    {
+        std::string buffer;
+        std::string head;
+        std::string_view chunk = ReadChunk(STDIN_FILENO, buffer);
+        // Enough of the input to tell the format, unless the mode fixes it.
+        while (!chunk.empty() && Resolve(options, FORMAT::UNKNOWN, head) == FORMAT::UNKNOWN)
+        {
+            head.append(chunk);
+            chunk = ReadChunk(STDIN_FILENO, buffer);
+        }
+        head.append(chunk);
+        FORMAT format = Resolve(options, FORMAT::UNKNOWN, head);
+
+        switch (options.mode)
+        {
+        case MODE::JSON_TO_XML:
+        {
+            Json::XmlTranscoder transcoder(out);
+            Pump<JsonPushReader>(transcoder, STDIN_FILENO, head, buffer, summary);
+            break;
+        }
+        case MODE::VALIDATE:
+            if (format == FORMAT::XML)
+            {
+                Xml::Handler ignore;
+                Pump<XmlPushReader>(ignore, STDIN_FILENO, head, buffer, summary);
+            }
+            else
+            {
+                Json::Handler ignore;
+                Pump<JsonPushReader>(ignore, STDIN_FILENO, head, buffer, summary);
+            }
+            return;
+        case MODE::XML_TO_JSON:
+        case MODE::REFORMAT:
+        {
+            std::string input = std::move(head);
+            for (chunk = ReadChunk(STDIN_FILENO, buffer); !chunk.empty(); chunk = ReadChunk(STDIN_FILENO, buffer))
+                input.append(chunk);
+            summary.bytesIn += input.size();
+            Worker worker;
+            Process(worker, options.mode, format, input, out);
+            return;
+        }
+        }
+        out.Write('\n');
+    }
+
+    // A file, memory-mapped.
+    void ConvertFile(Worker &worker, const Options &options, const fs::path &input, Writer &out, Summary &summary)
+    {
+        MappedFile file(input.string());
+        std::string_view text = file.View();
+        Process(worker, options.mode, Resolve(options, FormatOfPath(input), text), text, out);
+        summary.bytesIn += text.size();
+    }
+
+    // Where a single input goes: a file, or stdout for "-".
+    void Convert(const Options &options, Summary &summary)
+    {
+        std::unique_ptr<OutputFile> target;
+        if (options.output != "-")
+            target = std::make_unique<OutputFile>(options.output);
+
+        int indent = Indent(options);
+        Writer out(target ? target->Fd() : STDOUT_FILENO, indent > 0, indent);
+        if (options.input == "-")
+        {
+            Stream(options, out, summary);
+        }
+        else
+        {
+            Worker worker;
+            ConvertFile(worker, options, options.input, out, summary);
+        }
+        out.Flush();
+        summary.bytesOut += out.Written();
+        if (target)
+            target->Commit();
+    }
+
+    fs::path OutputPath(const Options &options, const fs::path &relative)
+    {
+        fs::path path = fs::path(options.output) / relative;
+        if (options.mode == MODE::JSON_TO_XML)
+            path.replace_extension(".xml");
+        else if (options.mode == MODE::XML_TO_JSON)
+            path.replace_extension(".json");
+        return path;
+    }
+
+    bool Selected(const Options &options, const fs::path &path)
+    {
+        FORMAT format = FormatOfPath(path);
+        FORMAT wanted = InputFormat(options.mode);
+        return format != FORMAT::UNKNOWN && (wanted == FORMAT::UNKNOWN || wanted == format);
+    }
+
+    // Walks `options.input` and hands each file to the pool. At most a few
+    // files per worker are queued at a time, so memory stays bounded by the
+    // number of jobs, not the size of the tree.
+    void ConvertDirectory(const Options &options, Summary &summary)
+    {
+        bool writes = options.mode != MODE::VALIDATE;
+        if (writes && options.output == "-")
+            throw std::runtime_error("A directory input needs an output directory");
+        fs::path root(options.input);
+        fs::path outputRoot;
+        if (writes)
+        {
+            fs::create_directories(options.output);
+            outputRoot = fs::canonical(options.output);
+        }
+
+        // Declared before the pool, which finishes its tasks before they go.
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t inFlight = 0;
+        ThreadPool pool(options.jobs);
+        size_t limit = pool.Size() * 4;
+
+        for (auto it = fs::recursive_directory_iterator(root); it != fs::recursive_directory_iterator(); ++it)
+        {
+            const fs::directory_entry &entry = *it;
+            if (entry.is_directory())
+            {
+                // An output directory inside the input is not read back.
+                if (writes && fs::equivalent(entry.path(), outputRoot))
+                    it.disable_recursion_pending();
+                continue;
+            }
+            if (!entry.is_regular_file() || !Selected(options, entry.path()))
+                continue;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [&]
+                          { return inFlight < limit; });
+                inFlight++;
+            }
+
+            fs::path input = entry.path();
+            fs::path output = writes ? OutputPath(options, fs::relative(input, root)) : fs::path();
+            pool.Submit([&options, &summary, &mutex, &done, &inFlight, input, output]
+                        {
+                            thread_local Worker worker;
+                            try
+                            {
+                                if (output.empty())
+                                {
+                                    std::string none;
+                                    Writer out(none);
+                                    ConvertFile(worker, options, input, out, summary);
+                                }
+                                else
+                                {
+                                    fs::create_directories(output.parent_path());
+                                    OutputFile target(output.string());
+                                    int indent = Indent(options);
+                                    {
+                                        Writer out(target.Fd(), indent > 0, indent);
+                                        ConvertFile(worker, options, input, out, summary);
+                                        out.Flush();
+                                        summary.bytesOut += out.Written();
+                                    }
+                                    target.Commit();
+                                }
+                            }
+                            catch (const std::exception &e)
+                            {
+                                summary.failed++;
+                                std::lock_guard<std::mutex> lock(mutex);
+                                std::cerr << input.string() << ": " << e.what() << std::endl;
+                            }
+                            summary.files++;
+
+                            std::lock_guard<std::mutex> lock(mutex);
+                            inFlight--;
+                            done.notify_one(); });
+        }
+        pool.Wait();
+    }
+
+    void PrintSummary(const Summary &summary, double seconds)
+    {
+        double in = summary.bytesIn / 1e6;
+        double out = summary.bytesOut / 1e6;
+        std::fprintf(stderr, "%zu file(s), %zu failed: %.1f MB in, %.1f MB out in %.3f s (%.1f MB/s)\n",
+                     summary.files.load(), summary.failed.load(), in, out, seconds,
+                     seconds > 0 ? in / seconds : 0.0);
+    }
+
+    bool ParseMode(const std::string &name, MODE &mode)
+    {
+        if (name == "json2xml")
+            mode = MODE::JSON_TO_XML;
+        else if (name == "xml2json")
+            mode = MODE::XML_TO_JSON;
+        else if (name == "validate")
+            mode = MODE::VALIDATE;
+        else if (name == "reformat")
+            mode = MODE::REFORMAT;
+        else
+            return false;
+        return true;
+    }
+
+    // Returns false on a usage error.
+    bool ParseArguments(int argc, char **argv, Options &options)
+    {
+        if (argc < 2 || !ParseMode(argv[1], options.mode))
+            return false;
+
+        int positional = 0;
+        for (int i = 2; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if ((arg == "-j" || arg == "--jobs") && hasValue)
+                options.jobs = std::strtoul(argv[++i], nullptr, 10);
+            else if (arg == "--indent" && hasValue)
+                options.indent = std::atoi(argv[++i]);
+            else if (arg == "--from" && hasValue)
+            {
+                std::string format = argv[++i];
+                if (format == "json")
+                    options.from = FORMAT::JSON;
+                else if (format == "xml")
+                    options.from = FORMAT::XML;
+                else
+                    return false;
+            }
+            else if (arg == "-q" || arg == "--quiet")
+                options.quiet = true;
+            else if (arg.size() > 1 && arg[0] == '-')
+                return false;
+            else if (positional == 0)
+                options.input = argv[i], positional++;
+            else if (positional == 1)
+                options.output = argv[i], positional++;
+            else
+                return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (argc > 1 && (std::strcmp(argv[1], "-h") == 0 || std::strcmp(argv[1], "--help") == 0))
+    {
+        std::cout << kUsage;
+        return 0;
+    }
+    if (!ParseArguments(argc, argv, options))
+    {
+        std::cerr << kUsage;
+        return 2;
+    }
+
+    Summary summary;
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        if (options.input != "-" && fs::is_directory(options.input))
+        {
+            ConvertDirectory(options, summary);
+        }
+        else
+        {
+            summary.files++;
+            Convert(options, summary);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        summary.failed++;
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!options.quiet)
+        PrintSummary(summary, seconds);
+    return summary.failed > 0 ? 1 : 0;
+}